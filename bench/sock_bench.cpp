@@ -0,0 +1,310 @@
+/**
+ * socketػѹ
+ * ͬһ̣߳ͻ˾127.0.0.1֮ͨѶͳƣ
+ *   1. ÿ뽨
+ *   2. 64B1MBϢʱӵķλ
+ *   3. MB/s
+ * sock_streamsend_n/recv_nsocketstreamԼWUYA_BENCH_ACEʱACEsock_pool
+ *
+ * 룺
+ *   g++ -O2 -DSOCKLEN_T -I../include sock_bench.cpp -o sock_bench -lpthread
+ *   g++ -O2 -DSOCKLEN_T -DWUYA_BENCH_ACE -I../include sock_bench.cpp -o sock_bench -lpthread -lACE
+ * ÷
+ *   sock_bench [-p port] [-n ] [-c Ӵ] [-m MB]
+ *   MB4ֽͷˣ14095֮
+ *
+ * @author wuya
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <pthread.h>
+#include <netinet/tcp.h>
+#include <wuya/socket.h>
+#include <wuya/socketstream.h>
+#include <wuya/timer.h>
+#include <wuya/get_opt.h>
+#ifdef WUYA_BENCH_ACE
+	#include <set>
+	#include <wuya/ace_sock_pool.h>
+#endif
+
+namespace {
+	const int MAX_MSG = 1024*1024;
+	const int sizes[] = {64, 256, 1024, 4096, 16384, 65536, 262144, 1048576};
+
+	enum bench_mode {
+		// յ4ֽڳȺԸóȵ
+		ECHO = 'E',
+		// ָֽ1ֽȷ
+		SINK = 'S',
+		// ֱӹرգڲٶ
+		CLOSE = 'C'
+	};
+
+	unsigned short port = 19527;
+	wuya::sock_acceptor acceptor;
+
+	void set_nodelay(wuya::sock_stream& s) {
+		int one = 1;
+		setsockopt(s.get_handler(), IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof one);
+	}
+
+	unsigned int get_u32(const unsigned char* p) {
+		return((unsigned int)p[0]<<24)|((unsigned int)p[1]<<16)|((unsigned int)p[2]<<8)|p[3];
+	}
+
+	void put_u32(unsigned char* p, unsigned int n) {
+		p[0] = (unsigned char)(n>>24);
+		p[1] = (unsigned char)(n>>16);
+		p[2] = (unsigned char)(n>>8);
+		p[3] = (unsigned char)n;
+	}
+
+	void* serve(void* data) {
+		wuya::sock_stream s;
+		s.set_handler((socket_type)(long)data);
+		set_nodelay(s);
+		std::vector<char> buf(MAX_MSG);
+		char mode;
+		if (s.recv_n(&mode, 1) != 1) {
+			s.close();
+			return 0;
+		}
+		unsigned char hdr[4];
+		while (mode != CLOSE && s.recv_n(hdr, 4) == 4) {
+			unsigned int n = get_u32(hdr);
+			if (mode == ECHO) {
+				if (n > (unsigned int)MAX_MSG || s.recv_n(&buf[0], n) != (int)n
+					|| s.send_n(&buf[0], n) != (int)n) {
+					break;
+				}
+			} else {
+				while (n > 0) {
+					int len = s.recv(&buf[0], n>(unsigned int)MAX_MSG?MAX_MSG:n);
+					if (len <= 0) {
+						break;
+					}
+					n -= len;
+				}
+				if (n != 0 || s.send_n("k", 1) != 1) {
+					break;
+				}
+			}
+		}
+		s.close();
+		return 0;
+	}
+
+	void* server(void*) {
+		while (true) {
+			wuya::sock_stream s;
+			if (acceptor.accept(s) != 0) {
+				continue;
+			}
+			pthread_t t;
+			pthread_create(&t, 0, serve, (void*)(long)s.get_handler());
+			pthread_detach(t);
+		}
+		return 0;
+	}
+
+	bool open_conn(wuya::sock_stream& s, char mode) {
+		wuya::sock_connector conn;
+		if (conn.connect(s, wuya::ip_addr(port, "127.0.0.1")) != 0) {
+			return false;
+		}
+		set_nodelay(s);
+		return s.send_n(&mode, 1) == 1;
+	}
+
+	void report(const char* name, int size, std::vector<double>& us) {
+		std::sort(us.begin(), us.end());
+		size_t n = us.size();
+		printf("%-14s %8d %8d %10.1f %10.1f %10.1f %10.1f %10.1f\n", name, size, (int)n,
+			   us[n/2], us[n*90/100], us[n*99/100], us[n*999/1000], us[n-1]);
+	}
+
+	int iterations(int size, int n) {
+		// Ϣܺʱ
+		int it = (int)(n*64LL/(size>64?size:64)*16);
+		if (it > n) it = n;
+		if (it < 20) it = 20;
+		return it;
+	}
+
+	void bench_connect(int times) {
+		wuya::timer t(true);
+		int ok = 0;
+		for (int i=0; i<times; ++i) {
+			wuya::sock_stream s;
+			if (open_conn(s, CLOSE)) {
+				++ok;
+			}
+			s.close();
+		}
+		double sec = t.end();
+		printf("connect        %d connections in %.3fs, %.0f conn/s\n", ok, sec, ok/sec);
+	}
+
+	void bench_send_recv(int n) {
+		wuya::sock_stream s;
+		if (!open_conn(s, ECHO)) {
+			printf("send_n/recv_n: connect failed\n");
+			return;
+		}
+		std::vector<char> buf(MAX_MSG+4);
+		for (size_t k=0; k<sizeof(sizes)/sizeof(sizes[0]); ++k) {
+			int size = sizes[k];
+			int it = iterations(size, n);
+			std::vector<double> us;
+			us.reserve(it);
+			for (int i=0; i<it; ++i) {
+				wuya::timer t(true);
+				put_u32((unsigned char*)&buf[0], size);
+				if (s.send_n(&buf[0], size+4) != size+4 || s.recv_n(&buf[0], size) != size) {
+					printf("send_n/recv_n: io error\n");
+					s.close();
+					return;
+				}
+				us.push_back(t.end()*1e6);
+			}
+			report("send_n/recv_n", size, us);
+		}
+		s.close();
+	}
+
+	void bench_socketstream(int n) {
+		wuya::sock_stream s;
+		if (!open_conn(s, ECHO)) {
+			printf("socketstream: connect failed\n");
+			return;
+		}
+		wuya::socketstream<wuya::sock_stream> ss(s);
+		std::vector<char> buf(MAX_MSG);
+		for (size_t k=0; k<sizeof(sizes)/sizeof(sizes[0]); ++k) {
+			int size = sizes[k];
+			int it = iterations(size, n);
+			std::vector<double> us;
+			us.reserve(it);
+			for (int i=0; i<it; ++i) {
+				wuya::timer t(true);
+				unsigned char hdr[4];
+				put_u32(hdr, size);
+				ss.write((const char*)hdr, 4);
+				ss.write(&buf[0], size);
+				ss.flush();
+				if (!ss.read(&buf[0], size)) {
+					printf("socketstream: io error\n");
+					s.close();
+					return;
+				}
+				us.push_back(t.end()*1e6);
+			}
+			report("socketstream", size, us);
+		}
+		s.close();
+	}
+
+	void bench_throughput(int mb) {
+		std::vector<char> buf(MAX_MSG);
+		for (size_t k=0; k<sizeof(sizes)/sizeof(sizes[0]); ++k) {
+			int size = sizes[k];
+			wuya::sock_stream s;
+			if (!open_conn(s, SINK)) {
+				printf("throughput: connect failed\n");
+				return;
+			}
+			unsigned int total = (unsigned int)mb*1024*1024;
+			unsigned char hdr[4];
+			put_u32(hdr, total);
+			wuya::timer t(true);
+			s.send_n(hdr, 4);
+			for (unsigned int sent=0; sent<total; sent+=size) {
+				int len = total-sent<(unsigned int)size?(int)(total-sent):size;
+				if (s.send_n(&buf[0], len) != len) {
+					break;
+				}
+			}
+			char ack;
+			s.recv_n(&ack, 1);
+			double sec = t.end();
+			printf("throughput     %8d %10.1f MB/s\n", size, mb/sec);
+			s.close();
+		}
+	}
+
+#ifdef WUYA_BENCH_ACE
+	void bench_pool(int n) {
+		char addr[32];
+		sprintf(addr, "127.0.0.1:%d", (int)port);
+		wuya::sock_pool* pool = wuya::sock_pool::init(addr, 1, 4);
+		std::vector<char> buf(MAX_MSG+4);
+		// ״ʹʱģʽֽ
+		std::set<ACE_SOCK_Stream*> inited;
+		for (size_t k=0; k<sizeof(sizes)/sizeof(sizes[0]); ++k) {
+			int size = sizes[k];
+			int it = iterations(size, n);
+			std::vector<double> us;
+			us.reserve(it);
+			for (int i=0; i<it; ++i) {
+				wuya::timer t(true);
+				ACE_SOCK_Stream* conn = pool->get_connect(addr);
+				if (conn == 0) {
+					printf("sock_pool: connect failed\n");
+					return;
+				}
+				if (inited.insert(conn).second) {
+					char mode = ECHO;
+					conn->send_n(&mode, 1);
+				}
+				put_u32((unsigned char*)&buf[0], size);
+				if (conn->send_n(&buf[0], size+4) != size+4 || conn->recv_n(&buf[0], size) != size) {
+					printf("sock_pool: io error\n");
+					pool->disconnect(conn);
+					return;
+				}
+				pool->close(conn);
+				us.push_back(t.end()*1e6);
+			}
+			report("sock_pool", size, us);
+		}
+	}
+#endif
+}
+
+int main(int argc, const char** argv) {
+	wuya::get_opt opt(argc, argv);
+	int n = 10000, conns = 2000, mb = 256;
+	if (opt.has_option('p')) port = (unsigned short)atoi(opt.get_option_param('p'));
+	if (opt.has_option('n')) n = atoi(opt.get_option_param('n'));
+	if (opt.has_option('c')) conns = atoi(opt.get_option_param('c'));
+	if (opt.has_option('m')) mb = atoi(opt.get_option_param('m'));
+	if (mb < 1 || mb > 4095) {
+		printf("-m must be between 1 and 4095\n");
+		return 1;
+	}
+
+	wuya::sock_init();
+	if (acceptor.open(wuya::ip_addr(port, "127.0.0.1"), 1) != 0) {
+		printf("listen on port %d failed\n", (int)port);
+		return 1;
+	}
+	pthread_t t;
+	pthread_create(&t, 0, server, 0);
+
+	bench_connect(conns);
+	printf("%-14s %8s %8s %10s %10s %10s %10s %10s\n", "rtt(us)", "size", "count",
+		   "p50", "p90", "p99", "p999", "max");
+	bench_send_recv(n);
+	bench_socketstream(n);
+#ifdef WUYA_BENCH_ACE
+	bench_pool(n);
+#endif
+	bench_throughput(mb);
+	wuya::sock_fini();
+	return 0;
+}
@@ -6,8 +6,16 @@
 #include <iomanip>
 #include <iostream>
 #include <string>
-#include <cassert>
 #include <list>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <streambuf>
 #include <ace/Thread_Manager.h>
 #include <ace/Condition_T.h>
 #include <ace/Time_Value.h>
@@ -17,7 +25,24 @@
 #include <wuya/timespan.h>
 #include <wuya/filestat.h>
 #include <wuya/fileopt.h>
+#include <wuya/atomic.h>
+#include <wuya/mpsc_ring.h>
+#include <wuya/spsc_ring.h>
+#include <wuya/histogram.h>
+#include <wuya/tls.h>
+#include <wuya/log_clock.h>
 #include <ace/OS_NS_sys_time.h>
+#include <wuya/filefind.h>
+#ifdef WUYA_LOG_USE_ZLIB
+    #include <zlib.h>
+#endif
+#if defined(WIN32)||defined(_WIN32)
+    #include <io.h>
+    #include <fcntl.h>
+#else
+    #include <unistd.h>
+    #include <fcntl.h>
+#endif
 
 namespace wuya {
     enum LOGLEVEL {
@@ -34,52 +59,340 @@ namespace wuya {
         NEVER_CHANGE
     };
 
+    // ־ʱĴʽ
+    enum OVERFLOW_POLICY {
+        // д־̵߳ȴ
+        OVERFLOW_BLOCK,
+        // Ϣ
+        OVERFLOW_DROP_NEWEST,
+        // ɵϢ
+        OVERFLOW_DROP_OLDEST,
+        // 𲻵keep_levelϢȴඪ
+        OVERFLOW_DROP_BY_LEVEL
+    };
+
     template<class output_type_policy>
     class logger;
+    struct log_metrics;
+
+    /**
+     * ڵlogger̼߳finiݴ˵ȴ˳ͷlogger
+     * ̰߳״ν˳ʹSTRIPESÿռһУ
+     * STRIPES߳ʱͬһϵ߳Իá
+     * ûй캯̬ʼڳʼ˳⡣
+     */
+    class log_gate {
+    public:
+        enum { STRIPES = 16 };
+        // 룬ر߳õļ뿪ʱ
+        int enter();
+        void leave(int stripe);
+        // ȴѽ߳뿪
+        void wait() const;
+    private:
+        struct stripe_type {
+            volatile long n;
+            char pad[64-sizeof(long)];
+        };
+        // 64ֽڶ룬һĿռ䣬ʹʱ׸б߽翪ʼ
+        stripe_type* counter(int i) const;
+        stripe_type stripes_[STRIPES+1];
+    };
+
+    /**
+     * ־ִ߳еĺ̨tracer::flush
+     * ߳ÿдһΣʱԼ100һΣӦܿ췵أҿܱlogger߳ͬʱá
+     * ֻܵǼǣע
+     */
+    class log_tasks {
+    public:
+        typedef void (*task_type)();
+        enum { MAX_TASKS = 8 };
+        // Ǽһʱfalse
+        static bool add(task_type task);
+        static void run();
+    private:
+        struct slot_type {
+            task_type task;
+            volatile long ready;
+        };
+        static slot_type* slots();
+        static volatile long& count();
+    };
+
+    /**
+     * ־ʽ
+     * ʽ߳ԤĹ̶Сڴ棻
+     * ͬһ߳ڸʽʱǶд־ʱʹöϵstd::string
+     */
+    class log_streambuf : public std::streambuf {
+    public:
+        enum { CAPACITY = 4096 };
+        log_streambuf();
+        ~log_streambuf();
+        // ѸʽݣúӦд
+        const char* data();
+        size_t size();
+    protected:
+        virtual int_type overflow(int_type c);
+        virtual std::streamsize xsputn(const char* s, std::streamsize n);
+    private:
+        struct thread_buffer {
+            bool busy;
+            char buf[CAPACITY];
+        };
+        static thread_buffer& local();
+        // ̶еheap_
+        void spill();
+
+        std::string heap_;
+        bool owner_;
+    private:
+        log_streambuf(const log_streambuf& );
+        log_streambuf& operator=(const log_streambuf& );
+    };
 
     template<class output_type_policy>
-    class logstream : public std::ostringstream{
+    class logstream : public std::ostream{
     public:
         explicit logstream();
         ~logstream();
         logstream& val();
+        std::string str();
+        // ñ־ļwuya::LOG_XXXʱԶ
+        void set_level(LOGLEVEL l);
     public:
-        static bool init(NAME_CHANGE_POLICY np=NEVER_CHANGE, const char* output_name="");
+        /**
+         * ־߳
+         *
+         * @param np          ļ
+         * @param output_name ɺ$DATE$TIME
+         * @param queue_size  ־еĲλ
+         * @param op          ʱĴʽ
+         * @param keep_level  opΪOVERFLOW_DROP_BY_LEVELʱڴ˼Ϣ
+         */
+        static bool init(NAME_CHANGE_POLICY np=NEVER_CHANGE, const char* output_name="",
+                         unsigned long queue_size=8192, OVERFLOW_POLICY op=OVERFLOW_BLOCK,
+                         LOGLEVEL keep_level=LOG_ERROR);
         static bool fini();
+        // ־̣߳δinitʱ0
+        static logger<output_type_policy>* instance();
+        // Զinit֮
+        static output_type_policy& output_type();
+        // ȡloggerͳƣδinitʱfalse
+        static bool metrics(log_metrics& m);
+        /**
+         * һϢ־Уlogstreamʱãδinitfiniʱ
+         */
+        static void submit(const char* msg, size_t len, LOGLEVEL level);
+        /**
+         * ͬˢϣȴ֮ǰеϢȫдд̣
+         * ߳еãabort()֮ǰյSIGTERMʱе
+         *
+         * @param timeout_ms ȴĺС0ʱһֱȴ
+         *
+         * @return ɷtrueʱδinitfalse
+         */
+        static bool flush(int timeout_ms);
+        using std::ostream::flush;
     private:
-        static logger<output_type_policy>* instance_;
+        static log_gate& gate();
+
+        static logger<output_type_policy>* volatile instance_;
+        log_streambuf buf_;
+        LOGLEVEL level_;
     private:
         logstream( const logstream& );
         const logstream& operator=( const logstream& );
     };
 
+    // 벹ո8ַ
+    inline const char* level_name(LOGLEVEL l) {
+        static const char names[][9] = {"ERROR   ", "WARN    ", "INFO    ", "DEBUG   "};
+        return names[l];
+    }
+
     // some useful operator
+    // ̺߳ţ벹ո8ַÿֻ߳ʽһ
     inline std::ostream& thread_id(std::ostream& io) {
-        io << std::left << std::setw(8) << ACE_Thread::self();
+        static WUYA_TLS char text[24] = {0};
+        static WUYA_TLS int len = 0;
+        if( len == 0 ) {
+            char tmp[24];
+            unsigned long id = (unsigned long)ACE_Thread::self();
+            int n = 0;
+            do {
+                tmp[n++] = (char)('0'+id%10);
+                id /= 10;
+            } while( id != 0 );
+            while( n > 0 ) {
+                text[len++] = tmp[--n];
+            }
+            while( len < 8 ) {
+                text[len++] = ' ';
+            }
+        }
+        io.write(text, len);
         return(io);
     }
 
+    // ǰʱ䣬log_clock::set_precisionãһո
     inline std::ostream& now(std::ostream& io) {
-        io << std::left << std::setw(20) << wuya::datetime::current_time().date_time_str();
+        char buf[log_clock::MAX_LEN+1];
+        int n = log_clock::format_now(buf);
+        buf[n++] = ' ';
+        io.write(buf, n);
         return(io);
     }
 
-    inline ostream& operator<< (ostream& io, LOGLEVEL l){
-        switch(l) {
-        case LOG_DEBUG:
-            io << std::left << std::setw(8) << "DEBUG";break;
-        case LOG_ERROR:
-            io << std::left << std::setw(8) << "ERROR";break;
-        case LOG_INFO:
-            io << std::left << std::setw(8) << "INFO";break;
-        case LOG_WARN:
-            io << std::left << std::setw(8) << "WARN";break;
-        }
+    inline std::ostream& operator<< (std::ostream& io, LOGLEVEL l){
+        io.write(level_name(l), 8);
         return io;
     }
 
+    template<class Op_>
+    inline logstream<Op_>& operator<< (logstream<Op_>& io, LOGLEVEL l){
+        io.set_level(l);
+        static_cast<std::ostream&>(io) << l;
+        return io;
+    }
+
+    /**
+     * ־ģ飬ÿģиԵļֵδʱʹȫֵ
+     * WUYA_DEFINE_LOG_MODULEΪȫֻ̬󣬹ʱǼǵģ
+     * пɰƵ±
+     */
+    class log_module {
+    public:
+        explicit log_module(const char* name);
+        const char* name() const;
+        // l־Ƿ
+        bool enabled(LOGLEVEL l) const;
+        void set_level(LOGLEVEL l);
+        // ָΪʹȫֵ
+        void reset_level();
+    public:
+        static void set_global_level(LOGLEVEL l);
+        static LOGLEVEL global_level();
+        static bool global_enabled(LOGLEVEL l);
+        // Ʋģ飬ڷ0
+        static log_module* find(const char* name);
+        /**
+         * ôü"net=DEBUG,db=WARN"Ϊ*ʱȫֵ
+         *
+         * @return ɹõ޷ʶʱ-1
+         */
+        static int configure(const char* spec);
+    private:
+        static volatile long& global_level_ref();
+        static log_module*& head();
+
+        const char* name_;
+        // С0ʾʹȫֵ
+        volatile long level_;
+        log_module* next_;
+    private:
+        log_module(const log_module& );
+        log_module& operator=(const log_module& );
+    };
+
+    /**
+     * ־õ㣬ɺ궨Ϊ̬󣬳ʼʱ
+     * rate0ʱͰƽÿrateburstGCRA㷨ֻһʱ
+     * every1ʱֻÿeveryеĵһƵ־̶߳ڻ
+     */
+    struct log_limit_site {
+        long rate;
+        long burst;
+        long every;
+        const char* file;
+        int line;
+        int level;
+        // ѵõĴڳ
+        volatile long count;
+        // һ־۵ʱ䣬log_clock::ticks()
+        volatile long long tat;
+        // δı
+        volatile long suppressed;
+        // 0ΪδǼǣ-1ΪڵǼ
+        volatile long id;
+
+        // εǷ
+        bool allow();
+    };
+
+    /**
+     * йƵĵõǼǱ̻߳
+     */
+    class log_limit_registry {
+    public:
+        enum { MAX_SITES = 4096 };
+        static void add(log_limit_site& site);
+        // ѵǼǵĸΪ1count()-1
+        static long count();
+        static log_limit_site* get(long id);
+    private:
+        static log_limit_site** sites();
+        static volatile long& next();
+    };
+
+    /**
+     * loggerͳõֱͼ̼߳¼߳ͬʱȡ
+     * 6λȣ1/32ÿԼ15KB
+     */
+    typedef histogram<6> log_histogram;
+
+    /**
+     * loggerͳƣlogstream::metrics()ȡÿ
+     * mmap_output_typeֱдĲԣϢУֽӳ
+     */
+    struct log_metrics {
+        // ǰеϢʷֵ
+        unsigned long queue_depth;
+        unsigned long max_queue_depth;
+        // е
+        unsigned long queue_capacity;
+        // дֽ
+        long long lines;
+        long long bytes;
+        // ʱ
+        long long dropped[LOG_DEBUG+1];
+        // ϢӷеԵʱ䣨΢룩
+        log_histogram latency;
+        // ÿλ
+        log_histogram batch;
+        // дļĺʱ΢룩лʱflushʱ
+        log_histogram write_time;
+    };
+
+    // ־ΪvoidʽWUYA_LOG_IF&ȼ<<?:
+    struct log_voidify {
+        void operator&(std::ostream& ) {}
+    };
 }
 
+// ڼޣڴ˼𣨸ϸ־䱻ȥ綨Ϊwuya::LOG_INFOȥDEBUG־
+#ifndef WUYA_LOG_MIN_LEVEL
+    #define WUYA_LOG_MIN_LEVEL wuya::LOG_DEBUG
+#endif
+
+// 㼶ʱֵκβԭһһʽif
+// ڲŵifУelseϣҲ-Wdangling-else
+#define WUYA_LOG_IF(level, cond) \
+    ( (level) > WUYA_LOG_MIN_LEVEL || !(cond) ) ? (void)0 : wuya::log_voidify() & mylog_cout << (level) << now
+
+// ־䣬ʱֵ
+// õҪֻ̬д䣻forжifelse
+#define WUYA_LOG_LIMIT(level, cond, rate, burst, every) \
+    for( bool wuya_log_once_ = !((level) > WUYA_LOG_MIN_LEVEL || !(cond)); wuya_log_once_; wuya_log_once_ = false ) \
+    for( static wuya::log_limit_site wuya_log_site_ = {rate, burst, every, __FILE__, __LINE__, level, 0, 0, 0, 0}; \
+         wuya_log_once_ && wuya_log_site_.allow(); wuya_log_once_ = false ) \
+        mylog_cout << (level) << now
+
+// ģ飬cppļУļWUYA_DECLARE_LOG_MODULEʹ
+#define WUYA_DEFINE_LOG_MODULE(name) wuya::log_module wuya_log_module_##name(#name)
+#define WUYA_DECLARE_LOG_MODULE(name) extern wuya::log_module wuya_log_module_##name
+
 // you can redefine as your need
 #ifdef _DEBUG
     #define log_debug_cout(message) do{ logdbg_cout << message << std::endl; }while(0)
@@ -89,102 +402,679 @@ namespace wuya {
 
 #define LOGSTREAM_COUT logstream<cout_output_type>
 #define mylog_cout LOGSTREAM().val()
-#define logerr_cout mylog_cout << wuya::LOG_ERROR<< std::setw(20) << now
-#define logwarn_cout mylog_cout << wuya::LOG_WARN<< std::setw(20) << now
-#define loginfo_cout mylog_cout << wuya::LOG_INFO<< std::setw(20) << now
-#define logdbg_cout mylog_cout << wuya::LOG_DEBUG<< std::setw(20) << now
+#define logerr_cout WUYA_LOG_IF(wuya::LOG_ERROR, wuya::log_module::global_enabled(wuya::LOG_ERROR))
+#define logwarn_cout WUYA_LOG_IF(wuya::LOG_WARN, wuya::log_module::global_enabled(wuya::LOG_WARN))
+#define loginfo_cout WUYA_LOG_IF(wuya::LOG_INFO, wuya::log_module::global_enabled(wuya::LOG_INFO))
+#define logdbg_cout WUYA_LOG_IF(wuya::LOG_DEBUG, wuya::log_module::global_enabled(wuya::LOG_DEBUG))
+
+// ģֵˣlogdbg_mod(net) << "..."
+#define logerr_mod(name) WUYA_LOG_IF(wuya::LOG_ERROR, wuya_log_module_##name.enabled(wuya::LOG_ERROR))
+#define logwarn_mod(name) WUYA_LOG_IF(wuya::LOG_WARN, wuya_log_module_##name.enabled(wuya::LOG_WARN))
+#define loginfo_mod(name) WUYA_LOG_IF(wuya::LOG_INFO, wuya_log_module_##name.enabled(wuya::LOG_INFO))
+#define logdbg_mod(name) WUYA_LOG_IF(wuya::LOG_DEBUG, wuya_log_module_##name.enabled(wuya::LOG_DEBUG))
+
+// ÿõƽÿnͻnlogerr_rate(10) << "..."
+#define logerr_rate(n) WUYA_LOG_LIMIT(wuya::LOG_ERROR, wuya::log_module::global_enabled(wuya::LOG_ERROR), n, n, 0)
+#define logwarn_rate(n) WUYA_LOG_LIMIT(wuya::LOG_WARN, wuya::log_module::global_enabled(wuya::LOG_WARN), n, n, 0)
+#define loginfo_rate(n) WUYA_LOG_LIMIT(wuya::LOG_INFO, wuya::log_module::global_enabled(wuya::LOG_INFO), n, n, 0)
+#define logdbg_rate(n) WUYA_LOG_LIMIT(wuya::LOG_DEBUG, wuya::log_module::global_enabled(wuya::LOG_DEBUG), n, n, 0)
+
+// ÿõÿnһ
+#define logerr_every(n) WUYA_LOG_LIMIT(wuya::LOG_ERROR, wuya::log_module::global_enabled(wuya::LOG_ERROR), 0, 0, n)
+#define logwarn_every(n) WUYA_LOG_LIMIT(wuya::LOG_WARN, wuya::log_module::global_enabled(wuya::LOG_WARN), 0, 0, n)
+#define loginfo_every(n) WUYA_LOG_LIMIT(wuya::LOG_INFO, wuya::log_module::global_enabled(wuya::LOG_INFO), 0, 0, n)
+#define logdbg_every(n) WUYA_LOG_LIMIT(wuya::LOG_DEBUG, wuya::log_module::global_enabled(wuya::LOG_DEBUG), 0, 0, n)
 
 //.............................ʵֲ.............................//
 namespace wuya {
+    inline volatile long& log_module::global_level_ref() {
+        static volatile long level = LOG_DEBUG;
+        return level;
+    }
+
+    inline log_module*& log_module::head() {
+        static log_module* h = 0;
+        return h;
+    }
+
+    inline log_module::log_module(const char* name):name_(name),level_(-1),next_(head()) {
+        head() = this;
+    }
+
+    inline const char* log_module::name() const {
+        return name_;
+    }
+
+    inline bool log_module::enabled(LOGLEVEL l) const {
+        long level = atomic_load(&level_);
+        if( level < 0 ) {
+            level = atomic_load(&global_level_ref());
+        }
+        return l <= level;
+    }
+
+    inline void log_module::set_level(LOGLEVEL l) {
+        atomic_store(&level_, l);
+    }
+
+    inline void log_module::reset_level() {
+        atomic_store(&level_, -1);
+    }
+
+    inline void log_module::set_global_level(LOGLEVEL l) {
+        atomic_store(&global_level_ref(), l);
+    }
+
+    inline LOGLEVEL log_module::global_level() {
+        return (LOGLEVEL)atomic_load(&global_level_ref());
+    }
+
+    inline bool log_module::global_enabled(LOGLEVEL l) {
+        return l <= atomic_load(&global_level_ref());
+    }
+
+    inline log_module* log_module::find(const char* name) {
+        for( log_module* m=head(); m!=0; m=m->next_ ) {
+            if( strcmp(m->name_, name) == 0 ) {
+                return m;
+            }
+        }
+        return 0;
+    }
+
+    inline int log_module::configure(const char* spec) {
+        static const char* names[] = {"ERROR", "WARN", "INFO", "DEBUG"};
+        int n = 0;
+        bool bad = false;
+        std::string item;
+        std::istringstream is(spec);
+        while( std::getline(is, item, ',') ) {
+            std::string::size_type eq = item.find('=');
+            if( eq == std::string::npos ) {
+                bad = true;
+                continue;
+            }
+            std::string name = item.substr(0, eq);
+            std::string value = item.substr(eq+1);
+            int level = -1;
+            for( int i=0; i<=LOG_DEBUG; ++i ) {
+                if( value == names[i] ) {
+                    level = i;
+                }
+            }
+            log_module* m = name=="*"?0:find(name.c_str());
+            if( level < 0 || (name != "*" && m == 0) ) {
+                bad = true;
+                continue;
+            }
+            if( m == 0 ) {
+                set_global_level((LOGLEVEL)level);
+            } else {
+                m->set_level((LOGLEVEL)level);
+            }
+            ++n;
+        }
+        return bad?-1:n;
+    }
+
+    inline bool log_limit_site::allow() {
+        bool ok = true;
+        if( every > 1 && (atomic_add(&count, 1)-1)%every != 0 ) {
+            ok = false;
+        }
+        if( ok && rate > 0 ) {
+            long long now = log_clock::ticks();
+            long long interval = log_clock::ticks_per_sec()/rate;
+            long long limit = interval*(burst>1?burst:1);
+            while( true ) {
+                long long t = atomic_load(&tat);
+                long long next = (t>now?t:now)+interval;
+                if( next-now > limit ) {
+                    ok = false;
+                    break;
+                }
+                if( atomic_cas(&tat, t, next) ) {
+                    break;
+                }
+            }
+        }
+        if( !ok ) {
+            atomic_add(&suppressed, 1);
+            if( atomic_load(&id) == 0 ) {
+                log_limit_registry::add(*this);
+            }
+        }
+        return ok;
+    }
+
+    inline log_limit_site** log_limit_registry::sites() {
+        static log_limit_site* s[MAX_SITES];
+        return s;
+    }
+
+    inline volatile long& log_limit_registry::next() {
+        static volatile long n = 1;
+        return n;
+    }
+
+    inline void log_limit_registry::add(log_limit_site& site) {
+        if( !atomic_cas(&site.id, 0, -1) ) {
+            return;
+        }
+        long id = atomic_add(&next(), 1)-1;
+        if( id < MAX_SITES ) {
+            sites()[id] = &site;
+        } else {
+            // ǼǱĵõճֻǲ
+            id = MAX_SITES;
+        }
+        atomic_store(&site.id, id);
+    }
+
+    inline long log_limit_registry::count() {
+        long n = atomic_load(&next());
+        return n<MAX_SITES?n:MAX_SITES;
+    }
+
+    inline log_limit_site* log_limit_registry::get(long id) {
+        // ѷšδдǼǱʱ0
+        return (id>0 && id<count())?sites()[id]:0;
+    }
+
+    inline int log_gate::enter() {
+        static volatile long next = 0;
+        static WUYA_TLS int stripe = -1;
+        if( stripe < 0 ) {
+            stripe = (int)(atomic_add(&next, 1)%STRIPES);
+        }
+        atomic_add(&counter(stripe)->n, 1);
+        return stripe;
+    }
+
+    inline void log_gate::leave(int stripe) {
+        atomic_add(&counter(stripe)->n, -1);
+    }
+
+    inline log_gate::stripe_type* log_gate::counter(int i) const {
+        return (stripe_type*)(((size_t)stripes_ + 63) & ~(size_t)63) + i;
+    }
+
+    inline void log_gate::wait() const {
+        for( int i=0; i<STRIPES; ++i ) {
+            while( atomic_load(&counter(i)->n) != 0 ) {
+                ACE_Thread::yield();
+            }
+        }
+    }
+
+    inline log_tasks::slot_type* log_tasks::slots() {
+        static slot_type s[MAX_TASKS];
+        return s;
+    }
+
+    inline volatile long& log_tasks::count() {
+        static volatile long n = 0;
+        return n;
+    }
+
+    inline bool log_tasks::add(task_type task) {
+        long i = atomic_add(&count(), 1)-1;
+        if( i >= MAX_TASKS ) {
+            return false;
+        }
+        slots()[i].task = task;
+        atomic_store(&slots()[i].ready, 1);
+        return true;
+    }
+
+    inline void log_tasks::run() {
+        long n = atomic_load(&count());
+        for( long i=0; i<n && i<MAX_TASKS; ++i ) {
+            if( atomic_load(&slots()[i].ready) ) {
+                slots()[i].task();
+            }
+        }
+    }
+
+    /**
+     * ļ
+     * ´αʱԤã̶߳ÿϢֻȽһ
+     */
     class name_change_policy{
     public:
         name_change_policy(NAME_CHANGE_POLICY np, const std::string& org_name);
-        bool name_changed();
-        void reset();
-        std::string name();
-        void change_name(const wuya::datetime& now);
-        void wait();
+        const std::string& name() const;
+        // Ƿѵʱ
+        bool due(std::time_t now) const;
+        // nowļ´αʱ
+        void change_name(std::time_t now);
 
         NAME_CHANGE_POLICY np_;
         const std::string& org_name_;
         std::string name_;
-        wuya::datetime lasttime_;
-        volatile bool name_changed_;
+        std::time_t due_;
+    private:
+        std::time_t next_due(std::time_t now) const;
+    };
+
+    /**
+     * ־ļĹ鵵ãlogstream::init֮ǰ޸ĲЧ
+     */
+    struct log_rotate {
+        // ļֽʱ0ʾС
+        unsigned long max_size;
+        // Ĺ鵵ļ0ʾɾ
+        int max_files;
+        // Ƿѹ鵵ļ趨WUYA_LOG_USE_ZLIBzlibδʱԣ鵵ļѹ
+        bool compress;
+
+        static log_rotate& defaults();
+    };
+
+    /**
+     * 鵵̣߳ѹļɾľļֻ߳ļ
+     */
+    class log_archiver{
+    public:
+        log_archiver(const log_rotate& cfg, const std::string& org_name);
+        ~log_archiver();
+        // 鵵filecurrentΪǰдļᱻɾ
+        void add(const std::string& file, const std::string& current);
+        static void thr_archive(void* data);
+    private:
+        struct collector {
+            explicit collector(std::vector<std::string>& files);
+            void operator()(const char* filename);
+            std::vector<std::string>& files_;
+        };
+        void archive();
+        bool compress(const std::string& file);
+        void prune(const std::string& current);
+
+        log_rotate cfg_;
+        std::string dir_;
+        // ļе$DATE$TIMEΪ*ƥ鵵ļ
+        std::string matcher_;
+        std::list<std::pair<std::string, std::string> > files_;
+        bool exit_;
         ACE_Thread_Mutex mutex_;
         ACE_Thread_Condition<ACE_Thread_Mutex> condition_;
         ACE_thread_t thread_id_;
     };
 
+    /**
+     * ṩ·ֻ߳еã
+     *   bool write(const std::string& msg);  дһϢȻ
+     *   bool flush(bool force);               棬forceΪfalseʱɰļƳ
+     *   bool sync();                          ȫ沢д̣ˢϺ˳
+     *   bool pending() const;                 ǷδĻ
+     *   int flush_interval() const;           лʱ߳ĵȴʱ䣨룩
+     *   bool open(const char* name);
+     *   void close();                         رǰȫ
+     */
     class cout_output_type{
     public:
         bool write(const std::string& msg);
+        bool flush(bool force=true);
+        bool sync();
+        bool pending() const;
+        int flush_interval() const;
         bool open(const char* name);
         void close();
     };
+
+    /**
+     * ļϢд뻺ܹһһwriteдļ
+     */
     class file_output_type{
     public:
+        struct config {
+            // ﵽֽʱдļ
+            size_t flush_bytes;
+            // еͣĺ0ʾһռд
+            int flush_interval;
+            // ÿдļǷfsync
+            bool fsync;
+        };
+        /**
+         * ȱʡãlogstream::init֮ǰ޸ĲЧ
+         */
+        static config& defaults();
+
+        file_output_type();
+        ~file_output_type();
         bool write(const std::string& msg);
+        bool flush(bool force=true);
+        bool sync();
+        bool pending() const;
+        int flush_interval() const;
         bool open(const char* name);
         void close();
     private:
-        std::ofstream stream_;
+        bool write_all(const char* buf, size_t len);
+        // ļд
+        void sync_file();
+        static long long now_msec();
+
+        int fd_;
+        config cfg_;
+        std::string buf_;
+        long long last_flush_;
     };
 // ݿʷʽأĿʵ 
 //  class db_output_type{
 //  };
 
+    /**
+     * Եԣȱʡʱ̵߳op.write(msg)
+     * ҪĲԿػģ壬sink_output_type
+     * directΪ1Ĳд־ֱ߳ӵwrite_directд룬У
+     * write_directfalseʱδ򿪣ԷУmmap_output_type
+     */
+    template<class Op_>
+    struct output_traits {
+        enum { direct = 0 };
+        static bool write(Op_& op, const std::string& msg, LOGLEVEL level);
+        static bool write_direct(Op_& op, const char* msg, size_t len, LOGLEVEL level);
+    };
+
+    // еһ־
+    struct log_record {
+        std::string msg;
+        LOGLEVEL level;
+        // ̷ֶ߳ʱڹ鲢ʱlog_clock::ticks()
+        long long stamp;
+    };
+
+    /**
+     * ־ãlogstream::init֮ǰ޸ĲЧ
+     */
+    struct log_queue {
+        // ÿд־߳ʹøԵĵ߶У֮ûйĻУ
+        // ߳ѯжУʱ鲢
+        bool per_thread;
+        // ÿ̶߳еĲλ
+        unsigned long thread_queue_size;
+
+        static log_queue& defaults();
+    };
+
+    // ̵߳־У߳˳̸߳
+    struct log_shard {
+        enum { FREE, ACTIVE, EXITED };
+        explicit log_shard(unsigned long size);
+
+        spsc_ring<log_record> ring;
+        volatile long state;
+    };
+
+    /**
+     * ־߳
+     * д־̰߳ѸʽõϢеԤλڴ棻
+     * ߳̿ʱҪѣдϢֻһΡ
+     */
     template<class output_type_policy>
     class logger{
     public:
-        logger(NAME_CHANGE_POLICY np, const char* output_name);
+        enum {
+            // ÿλԤֽʱŷڴ
+            SLOT_RESERVE = 256,
+            // ϢʱͳƵļ룩
+            DROP_REPORT_INTERVAL = 10,
+            // ̶߳е߳ʹù
+            MAX_SHARDS = 256
+        };
+        logger(NAME_CHANGE_POLICY np, const char* output_name, unsigned long queue_size=8192,
+               OVERFLOW_POLICY op=OVERFLOW_BLOCK, LOGLEVEL keep_level=LOG_ERROR);
         ~logger();
-        void add_message(const std::string& msg);
+        void add_message(const std::string& msg, LOGLEVEL level=LOG_INFO);
+        void add_message(const char* msg, size_t len, LOGLEVEL level=LOG_INFO);
+        // ۼƶϢ
+        unsigned long dropped(LOGLEVEL level) const;
+        // ȡͳƵĿգ߳е
+        void metrics(log_metrics& m) const;
+        // ͬˢϣlogstream::flush
+        bool flush(int timeout_ms);
+        // Զֻ߳ʹã÷б֤̰߳ȫ
+        output_type_policy& output_type();
 
         static void thr_output(void* data);
-        static void thr_change_name(void* data);
     private:
+        struct shard_ref {
+            const void* owner;
+            long gen;
+            log_shard* shard;
+        };
+        // ǰ̵߳ĶУﵽMAX_SHARDSʱ0
+        log_shard* local_shard();
+        log_shard* attach_shard();
+        static void shard_exit(void* data);
+        bool add_to_shard(log_shard* s, const char* msg, size_t len, LOGLEVEL level);
+        // ʱ鲢̶߳м
+        void drain_shards();
+        // ǷдϢ
+        bool readable();
+        void write_record(const log_record& r);
         void output();
-        void change_name();
+        // ׸ļʱ䡢С
+        void rotate(std::time_t now);
+        void notify();
+        void report_dropped();
+        // õ㱻Ƶ
+        void report_suppressed();
+        // ־ϢͨϢһwrite_record
+        void write_report(const std::string& msg, LOGLEVEL level);
+        // еϢ
+        unsigned long queue_depth() const;
+        static long long ticks_to_usec(long long ticks);
 
         std::string org_name_;
         volatile bool exit_;
         name_change_policy np_;
         output_type_policy op_;
+        log_rotate rotate_;
+        log_archiver* archiver_;
+        bool opened_;
+        // ǰļдֽ
+        unsigned long written_;
+        // ϴιʱ估ţɹ鵵ļ
+        std::time_t last_rotate_;
+        int seq_;
 
         ACE_Thread_Mutex mutex_;
         ACE_Thread_Condition<ACE_Thread_Mutex> condition_;
         ACE_thread_t thread_id_;
-        std::list<std::string> logs_;
+        // ɵˢţʱ㲥flushed_
+        volatile long long flush_req_;
+        volatile long long flush_done_;
+        ACE_Thread_Condition<ACE_Thread_Mutex> flushed_;
+        mpsc_ring<log_record> logs_;
+        // ߳Ƿڵȴ
+        volatile long sleeping_;
+        OVERFLOW_POLICY overflow_;
+        LOGLEVEL keep_level_;
+        volatile long dropped_[LOG_DEBUG+1];
+        // ϴͳʱۼֵ
+        long reported_[LOG_DEBUG+1];
+        std::time_t last_report_;
+
+        log_queue queue_;
+        // Ⱥ󴴽loggerʹ̻߳ĶָʧЧ
+        long gen_;
+        log_shard* shards_[MAX_SHARDS];
+        volatile long shard_count_;
+        ACE_Thread_Mutex shard_mutex_;
+        ACE_thread_key_t shard_key_;
+        // 鲢ʱѴӹȡδϢ
+        log_record* held_;
+        unsigned long held_pos_;
+
+        // ͳƣ̸ֻ߳
+        volatile long long lines_;
+        volatile long long bytes_;
+        volatile long max_depth_;
+        log_histogram latency_;
+        log_histogram batch_;
+        log_histogram write_time_;
     };
 
     template<class Op_>
-    logger<Op_>* logstream<Op_>::instance_;
+    logger<Op_>* volatile logstream<Op_>::instance_;
 
     template<class Op_>
-    bool logstream<Op_>::init(NAME_CHANGE_POLICY np, const char* output_name) {
+    bool logstream<Op_>::init(NAME_CHANGE_POLICY np, const char* output_name, unsigned long queue_size,
+                              OVERFLOW_POLICY op, LOGLEVEL keep_level) {
         if(instance_ == 0) {
-            instance_ = new logger<Op_>(np, output_name);
+			// ߳̿ڹʱļȽĿ¼
 			wuya::filestat fs(output_name);
 			make_dir(fs.get_filepath());
+            instance_ = new logger<Op_>(np, output_name, queue_size, op, keep_level);
         }
         return true;
     }
 
     template<class Op_>
     bool logstream<Op_>::fini() {
-        delete instance_;
+        logger<Op_>* l = instance_;
+        if( l == 0 ) {
+            return true;
+        }
+        // ʹµĵÿloggerٵڵõ߳뿪˺в
+        // submit()еļͶȡдԣ֮һܿԷд
         instance_ = 0;
+        atomic_fence();
+        gate().wait();
+        // ʱ߳ȡȫϢд̺˳
+        delete l;
         return true;
     }
 
+    inline log_streambuf::thread_buffer& log_streambuf::local() {
+        static WUYA_TLS thread_buffer tb;
+        return tb;
+    }
+
+    inline log_streambuf::log_streambuf():owner_(false) {
+        thread_buffer& tb = local();
+        if( !tb.busy ) {
+            tb.busy = true;
+            owner_ = true;
+            setp(tb.buf, tb.buf+CAPACITY);
+        }
+    }
+
+    inline log_streambuf::~log_streambuf() {
+        if( owner_ ) {
+            local().busy = false;
+        }
+    }
+
+    inline void log_streambuf::spill() {
+        if( pptr() != pbase() ) {
+            heap_.append(pbase(), pptr()-pbase());
+            setp(pbase(), epptr());
+        }
+    }
+
+    inline log_streambuf::int_type log_streambuf::overflow(int_type c) {
+        spill();
+        if( !traits_type::eq_int_type(c, traits_type::eof()) ) {
+            heap_.push_back(traits_type::to_char_type(c));
+        }
+        return traits_type::not_eof(c);
+    }
+
+    inline std::streamsize log_streambuf::xsputn(const char* s, std::streamsize n) {
+        if( n <= epptr()-pptr() ) {
+            memcpy(pptr(), s, (size_t)n);
+            pbump((int)n);
+        } else {
+            spill();
+            heap_.append(s, (size_t)n);
+        }
+        return n;
+    }
+
+    inline const char* log_streambuf::data() {
+        if( heap_.empty() ) {
+            return pbase();
+        }
+        spill();
+        return heap_.data();
+    }
+
+    inline size_t log_streambuf::size() {
+        if( heap_.empty() ) {
+            return pptr()-pbase();
+        }
+        spill();
+        return heap_.size();
+    }
+
+    template<class Op_>
+    logger<Op_>* logstream<Op_>::instance() {
+        return instance_;
+    }
+
+    template<class Op_>
+    Op_& logstream<Op_>::output_type() {
+        return instance_->output_type();
+    }
+
+    template<class Op_>
+    bool logstream<Op_>::metrics(log_metrics& m) {
+        int stripe = gate().enter();
+        logger<Op_>* l = instance_;
+        if( l != 0 ) {
+            l->metrics(m);
+        }
+        gate().leave(stripe);
+        return l != 0;
+    }
+
+    template<class Op_>
+    void logstream<Op_>::submit(const char* msg, size_t len, LOGLEVEL level) {
+        int stripe = gate().enter();
+        logger<Op_>* l = instance_;
+        if( l != 0 ) {
+            l->add_message(msg, len, level);
+        }
+        gate().leave(stripe);
+    }
+
+    template<class Op_>
+    bool logstream<Op_>::flush(int timeout_ms) {
+        int stripe = gate().enter();
+        logger<Op_>* l = instance_;
+        bool ret = l!=0 && l->flush(timeout_ms);
+        gate().leave(stripe);
+        return ret;
+    }
+
+    template<class Op_>
+    log_gate& logstream<Op_>::gate() {
+        static log_gate g;
+        return g;
+    }
+
     template<class Op_>
-    logstream<Op_>::logstream(){
+    logstream<Op_>::logstream():std::ostream(0),level_(LOG_INFO){
+        rdbuf(&buf_);
     }
 
     template<class Op_>
     logstream<Op_>::~logstream() {
-        if (instance_)
-            instance_->add_message(str());
+        submit(buf_.data(), buf_.size(), level_);
+    }
+
+    template<class Op_>
+    std::string logstream<Op_>::str() {
+        return std::string(buf_.data(), buf_.size());
+    }
+
+    template<class Op_>
+    void logstream<Op_>::set_level(LOGLEVEL l) {
+        level_ = l;
     }
 
     template<class Op_>
@@ -193,145 +1083,694 @@ namespace wuya {
     }
 
     template<class Op_>
-    logger<Op_>::logger(NAME_CHANGE_POLICY np, const char* output_name):
+    logger<Op_>::logger(NAME_CHANGE_POLICY np, const char* output_name, unsigned long queue_size,
+                        OVERFLOW_POLICY op, LOGLEVEL keep_level):
         org_name_(output_name),
         np_(np, org_name_),
         exit_(false),
-        condition_(mutex_){
+        rotate_(log_rotate::defaults()),
+        archiver_(0),
+        opened_(false),
+        written_(0),
+        last_rotate_(0),
+        seq_(0),
+        condition_(mutex_),
+        flush_req_(0),
+        flush_done_(0),
+        flushed_(mutex_),
+        logs_(queue_size),
+        sleeping_(0),
+        overflow_(op),
+        keep_level_(keep_level),
+        last_report_(std::time(0)),
+        queue_(log_queue::defaults()),
+        shard_count_(0),
+        held_(0),
+        held_pos_(0),
+        lines_(0),
+        bytes_(0),
+        max_depth_(0){
+            static volatile long generation = 0;
+            gen_ = atomic_add(&generation, 1);
+            for(unsigned long i=0; i<logs_.capacity(); ++i) {
+                logs_.slot(i).msg.reserve(SLOT_RESERVE);
+            }
+            if(queue_.per_thread) {
+                // ߳˳ʱпɸ
+                ACE_Thread::keycreate(&shard_key_, shard_exit);
+            }
+            for(int i=0; i<=LOG_DEBUG; ++i) {
+                dropped_[i] = 0;
+                reported_[i] = 0;
+            }
+#ifdef WUYA_LOG_USE_ZLIB
+            bool compress = rotate_.compress;
+#else
+            bool compress = false;
+#endif
+            if(compress || rotate_.max_files > 0) {
+                archiver_ = new log_archiver(rotate_, org_name_);
+            }
             ACE_Thread_Manager::instance()->spawn((ACE_THR_FUNC)thr_output, (void*)this, THR_NEW_LWP | THR_JOINABLE
                                                   | THR_INHERIT_SCHED, &thread_id_);
-            if(np != NEVER_CHANGE) {
-                ACE_Thread_Manager::instance()->spawn((ACE_THR_FUNC)thr_change_name, (void*)this, THR_NEW_LWP | THR_JOINABLE
-                                                      | THR_INHERIT_SCHED, &np_.thread_id_);
-            }
             ACE_Thread::yield();
     }
 
     template<class Op_>
     logger<Op_>::~logger(){
+        // ÷logstream::fini֤ʱû߳д־߳ȡк˳
         exit_ = true;
         {
             ACE_GUARD(ACE_Thread_Mutex, guard, mutex_);
             condition_.signal();
-            ACE_GUARD(ACE_Thread_Mutex, guard2, np_.mutex_);
-            np_.condition_.signal();
         }
         ACE_Thread_Manager::instance()->join(thread_id_);
-        if(np_.np_ != NEVER_CHANGE) {
-            ACE_Thread_Manager::instance()->join(np_.thread_id_);
-        }
         op_.close();
+        // ȴѹļ鵵
+        delete archiver_;
+        if(queue_.per_thread) {
+            // ˺߳˳ʱٷʶ
+            ACE_Thread::keyfree(shard_key_);
+            for(long i=0; i<shard_count_; ++i) {
+                delete shards_[i];
+            }
+        }
     }
 
     template<class Op_>
-    void logger<Op_>::add_message(const std::string& msg){
-        ACE_GUARD(ACE_Thread_Mutex, guard, mutex_);
-        logs_.push_back(msg);
-        condition_.signal();
+    void logger<Op_>::add_message(const std::string& msg, LOGLEVEL level){
+        add_message(msg.data(), msg.size(), level);
     }
 
     template<class Op_>
-    void logger<Op_>::thr_output(void* data){
-        ((logger*)data)->output();
+    void logger<Op_>::add_message(const char* msg, size_t len, LOGLEVEL level){
+        if( output_traits<Op_>::direct && output_traits<Op_>::write_direct(op_, msg, len, level) ) {
+            return;
+        }
+        if( queue_.per_thread ) {
+            log_shard* s = local_shard();
+            if( s != 0 ) {
+                if( add_to_shard(s, msg, len, level) ) {
+                    notify();
+                }
+                return;
+            }
+        }
+        // ڰ̷ֶ߳ʱĹ鲢Լͳӳ
+        long long stamp = log_clock::ticks();
+        unsigned long pos;
+        log_record* slot;
+        while( (slot = logs_.claim(pos)) == 0 ) {
+            // 
+            switch( overflow_ ) {
+            case OVERFLOW_DROP_NEWEST:
+                atomic_add(&dropped_[level], 1);
+                return;
+            case OVERFLOW_DROP_BY_LEVEL:
+                if( level > keep_level_ ) {
+                    atomic_add(&dropped_[level], 1);
+                    return;
+                }
+                break;
+            case OVERFLOW_DROP_OLDEST:
+                {
+                    unsigned long old;
+                    log_record* r = logs_.peek(old);
+                    if( r != 0 ) {
+                        atomic_add(&dropped_[r->level], 1);
+                        logs_.release(old);
+                    }
+                }
+                continue;
+            default:
+                break;
+            }
+            // ߳ڳλ
+            notify();
+            ACE_Thread::yield();
+        }
+        slot->msg.assign(msg, len);
+        slot->level = level;
+        slot->stamp = stamp;
+        logs_.publish(pos);
+        notify();
     }
 
     template<class Op_>
-    void logger<Op_>::thr_change_name(void* data){
-        ((logger*)data)->change_name();
+    log_shard* logger<Op_>::local_shard(){
+        static WUYA_TLS shard_ref ref;
+        if( ref.owner != this || ref.gen != gen_ ) {
+            ref.shard = attach_shard();
+            ref.owner = this;
+            ref.gen = gen_;
+        }
+        return ref.shard;
+    }
+
+    template<class Op_>
+    log_shard* logger<Op_>::attach_shard(){
+        log_shard* s = 0;
+        long n = atomic_load(&shard_count_);
+        for(long i=0; i<n && s==0; ++i) {
+            if( atomic_cas(&shards_[i]->state, log_shard::FREE, log_shard::ACTIVE) ) {
+                s = shards_[i];
+            }
+        }
+        if( s == 0 ) {
+            ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, shard_mutex_, 0);
+            n = shard_count_;
+            if( n >= MAX_SHARDS ) {
+                return 0;
+            }
+            s = new log_shard(queue_.thread_queue_size);
+            for(unsigned long i=0; i<s->ring.capacity(); ++i) {
+                s->ring.slot(i).msg.reserve(SLOT_RESERVE);
+            }
+            shards_[n] = s;
+            // release屣֤߳̿ʱshards_[n]д
+            atomic_store(&shard_count_, n+1);
+        }
+        ACE_Thread::setspecific(shard_key_, s);
+        return s;
+    }
+
+    template<class Op_>
+    void logger<Op_>::shard_exit(void* data){
+        atomic_store(&((log_shard*)data)->state, log_shard::EXITED);
+    }
+
+    template<class Op_>
+    bool logger<Op_>::add_to_shard(log_shard* s, const char* msg, size_t len, LOGLEVEL level){
+        unsigned long pos;
+        log_record* slot;
+        while( (slot = s->ring.claim(pos)) == 0 ) {
+            // ߶в߳ӣOVERFLOW_DROP_OLDESTOVERFLOW_DROP_NEWEST
+            if( overflow_ == OVERFLOW_DROP_NEWEST || overflow_ == OVERFLOW_DROP_OLDEST
+                || (overflow_ == OVERFLOW_DROP_BY_LEVEL && level > keep_level_) ) {
+                atomic_add(&dropped_[level], 1);
+                return false;
+            }
+            notify();
+            ACE_Thread::yield();
+        }
+        slot->msg.assign(msg, len);
+        slot->level = level;
+        slot->stamp = log_clock::ticks();
+        s->ring.publish(pos);
+        return true;
     }
 
+    template<class Op_>
+    unsigned long logger<Op_>::dropped(LOGLEVEL level) const {
+        return (unsigned long)atomic_load(&dropped_[level]);
+    }
+
+    template<class Op_>
+    Op_& logger<Op_>::output_type() {
+        return op_;
+    }
+
+    template<class Op_>
+    void logger<Op_>::metrics(log_metrics& m) const {
+        m.queue_depth = queue_depth();
+        m.max_queue_depth = (unsigned long)atomic_load(&max_depth_);
+        m.queue_capacity = logs_.capacity();
+        m.lines = atomic_load(&lines_);
+        m.bytes = atomic_load(&bytes_);
+        for(int i=0; i<=LOG_DEBUG; ++i) {
+            m.dropped[i] = atomic_load(&dropped_[i]);
+        }
+        m.latency = latency_;
+        m.batch = batch_;
+        m.write_time = write_time_;
+    }
+
+    template<class Op_>
+    bool logger<Op_>::flush(int timeout_ms) {
+        long long req = atomic_add(&flush_req_, 1);
+        notify();
+        ACE_Time_Value deadline = ACE_OS::gettimeofday();
+        deadline += ACE_Time_Value(timeout_ms/1000, (timeout_ms%1000)*1000);
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, mutex_, false);
+        while( atomic_load(&flush_done_) < req ) {
+            if( timeout_ms >= 0 && !(ACE_OS::gettimeofday() < deadline) ) {
+                return false;
+            }
+            flushed_.wait(timeout_ms<0?0:&deadline);
+        }
+        return true;
+    }
+
+    template<class Op_>
+    unsigned long logger<Op_>::queue_depth() const {
+        unsigned long n = logs_.size();
+        long shards = atomic_load(&shard_count_);
+        for(long i=0; i<shards; ++i) {
+            n += shards_[i]->ring.size();
+        }
+        return n;
+    }
+
+    template<class Op_>
+    long long logger<Op_>::ticks_to_usec(long long ticks) {
+        static const long long per_usec = log_clock::ticks_per_sec()/1000000;
+        return per_usec>0?ticks/per_usec:ticks*1000000/log_clock::ticks_per_sec();
+    }
+
+    template<class Op_>
+    inline bool output_traits<Op_>::write(Op_& op, const std::string& msg, LOGLEVEL level) {
+        return op.write(msg);
+    }
+
+    template<class Op_>
+    inline bool output_traits<Op_>::write_direct(Op_& op, const char* msg, size_t len, LOGLEVEL level) {
+        return false;
+    }
+
+    template<class Op_>
+    void logger<Op_>::report_dropped(){
+        std::time_t t = std::time(0);
+        if( t-last_report_ < DROP_REPORT_INTERVAL ) {
+            return;
+        }
+        last_report_ = t;
+        report_suppressed();
+        long n[LOG_DEBUG+1];
+        long total = 0;
+        for(int i=0; i<=LOG_DEBUG; ++i) {
+            n[i] = atomic_load(&dropped_[i])-reported_[i];
+            reported_[i] += n[i];
+            total += n[i];
+        }
+        if( total == 0 ) {
+            return;
+        }
+        std::ostringstream os;
+        os << LOG_WARN << now << "logger dropped " << total
+           << " messages (ERROR " << n[LOG_ERROR] << ", WARN " << n[LOG_WARN]
+           << ", INFO " << n[LOG_INFO] << ", DEBUG " << n[LOG_DEBUG] << ")" << std::endl;
+        write_report(os.str(), LOG_WARN);
+    }
+
+    template<class Op_>
+    void logger<Op_>::report_suppressed(){
+        long count = log_limit_registry::count();
+        for(long i=1; i<count; ++i) {
+            log_limit_site* site = log_limit_registry::get(i);
+            long n = site==0?0:atomic_exchange(&site->suppressed, 0);
+            if( n == 0 ) {
+                continue;
+            }
+            std::ostringstream os;
+            os << (LOGLEVEL)site->level << now << "suppressed " << n << " messages at "
+               << site->file << ":" << site->line << std::endl;
+            write_report(os.str(), (LOGLEVEL)site->level);
+        }
+    }
+
+    template<class Op_>
+    void logger<Op_>::write_report(const std::string& msg, LOGLEVEL level){
+        log_record r;
+        r.msg = msg;
+        r.level = level;
+        r.stamp = log_clock::ticks();
+        write_record(r);
+    }
+
+    template<class Op_>
+    void logger<Op_>::notify(){
+        // output()жsleeping_ԣ֮һܿԷд
+        atomic_fence();
+        if( atomic_load(&sleeping_) && atomic_cas(&sleeping_, 1, 0) ) {
+            ACE_GUARD(ACE_Thread_Mutex, guard, mutex_);
+            condition_.signal();
+        }
+    }
+
+    template<class Op_>
+    void logger<Op_>::thr_output(void* data){
+        ((logger*)data)->output();
+    }
+
+
     template<class Op_>
     void logger<Op_>::output(){
+        unsigned long pos;
+        log_record* r;
+        if( output_traits<Op_>::direct ) {
+            // ֱдĲԲwrite_recordʱ
+            rotate(std::time(0));
+        }
         while( true ) {
+            // ȶ־ȡУexit_ˢʱǰϢһȡ
+            bool exiting = exit_;
+            long long want = atomic_load(&flush_req_);
+            long long lines = lines_;
+            long depth = (long)queue_depth();
+            if( depth > max_depth_ ) {
+                atomic_store(&max_depth_, depth);
+            }
+            if( queue_.per_thread ) {
+                drain_shards();
+            } else {
+                while( (r = logs_.peek(pos)) != 0 ) {
+                    write_record(*r);
+                    logs_.release(pos);
+                }
+            }
+            report_dropped();
+            if( lines_ > lines ) {
+                batch_.record(lines_-lines);
+            }
+            // ѿգһϢһд
+            if( op_.pending() ) {
+                long long start = log_clock::ticks();
+                op_.flush(false);
+                if( !op_.pending() ) {
+                    write_time_.record(ticks_to_usec(log_clock::ticks()-start));
+                }
+            } else {
+                op_.flush(false);
+            }
+            log_tasks::run();
+            if( exiting || want != flush_done_ ) {
+                op_.sync();
+                ACE_GUARD(ACE_Thread_Mutex, guard, mutex_);
+                atomic_store(&flush_done_, want);
+                flushed_.broadcast();
+            }
+            if( exiting ) {
+                return;
+            }
             ACE_GUARD(ACE_Thread_Mutex, guard, mutex_);
-            while( logs_.empty() ) {
-                if( exit_ ) {
-                    return;
+            atomic_store(&sleeping_, 1);
+            atomic_fence();
+            if( !readable() && !exit_ && atomic_load(&flush_req_) == flush_done_ ) {
+                // лʱȵ´дʱ䣻ʱֻǷnotify()
+                ACE_Time_Value t(0, 100000);
+                if( op_.pending() && op_.flush_interval() < 100 ) {
+                    t = ACE_Time_Value(0, op_.flush_interval()*1000);
                 }
-                condition_.wait();
+                t += ACE_OS::gettimeofday();
+                condition_.wait(&t);
             }
-            if( np_.name_changed() ) {
-                op_.close();
-                op_.open(np_.name().c_str());
-                np_.reset();
+            atomic_store(&sleeping_, 0);
+        }
+    }
+
+    template<class Op_>
+    void logger<Op_>::write_record(const log_record& r){
+        std::time_t now = std::time(0);
+        // ֱдĲйļںʹС
+        if( !opened_ || (!output_traits<Op_>::direct && (np_.due(now)
+            || (rotate_.max_size > 0 && written_ > 0 && written_+r.msg.size() > rotate_.max_size))) ) {
+            rotate(now);
+        }
+        output_traits<Op_>::write(op_, r.msg, r.level);
+        written_ += (unsigned long)r.msg.size();
+        latency_.record(ticks_to_usec(log_clock::ticks()-r.stamp));
+        atomic_store(&lines_, lines_+1);
+        atomic_store(&bytes_, bytes_+(long long)r.msg.size());
+    }
+
+    template<class Op_>
+    void logger<Op_>::drain_shards(){
+        while( true ) {
+            // ڲÿжʱСһ
+            log_shard* best = 0;
+            log_record* best_r = 0;
+            unsigned long best_pos = 0;
+            long n = atomic_load(&shard_count_);
+            for(long i=0; i<n; ++i) {
+                log_shard* s = shards_[i];
+                unsigned long pos;
+                log_record* r = s->ring.peek(pos);
+                if( r == 0 ) {
+                    // ߳˳Ҷѿգɱ̸߳
+                    if( atomic_load(&s->state) == log_shard::EXITED ) {
+                        atomic_cas(&s->state, log_shard::EXITED, log_shard::FREE);
+                    }
+                } else if( best_r == 0 || r->stamp < best_r->stamp ) {
+                    best = s;
+                    best_r = r;
+                    best_pos = pos;
+                }
             }
-            while( !logs_.empty() ) {
-                op_.write(logs_.front());
-                logs_.pop_front();
+            // MAX_SHARDS߳ʹùУpeekӣȡݴ
+            if( held_ == 0 ) {
+                held_ = logs_.peek(held_pos_);
+            }
+            if( held_ != 0 && (best_r == 0 || held_->stamp < best_r->stamp) ) {
+                write_record(*held_);
+                logs_.release(held_pos_);
+                held_ = 0;
+            } else if( best_r != 0 ) {
+                write_record(*best_r);
+                best->ring.release(best_pos);
+            } else {
+                return;
             }
         }
     }
 
     template<class Op_>
-    void logger<Op_>::change_name(){
-        while(!exit_) {
-            np_.wait();
-            wuya::datetime now = wuya::datetime::current_time();
+    bool logger<Op_>::readable(){
+        if( logs_.readable() || held_ != 0 ) {
+            return true;
+        }
+        long n = atomic_load(&shard_count_);
+        for(long i=0; i<n; ++i) {
+            if( shards_[i]->ring.readable() ) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template<class Op_>
+    void logger<Op_>::rotate(std::time_t now){
+        std::string old = np_.name();
+        if( opened_ ) {
+            op_.close();
+        }
+        if( np_.due(now) ) {
             np_.change_name(now);
-            np_.name_changed_ = true;
-            np_.lasttime_ = now;
         }
+        std::string archive = old;
+        if( opened_ && np_.name() == old ) {
+            // ļʱѾļΪ"ԭ.yyyymmddhhmmss.nnn"ͬһŵʹֵΪʱ˳
+            seq_ = (now == last_rotate_)?seq_+1:0;
+            last_rotate_ = now;
+            std::string base = old+"."+wuya::datetime(now).date_time_str2();
+            do {
+                std::ostringstream os;
+                os << base << "." << std::setw(3) << std::setfill('0') << seq_++;
+                archive = os.str();
+            } while( wuya::filestat(archive.c_str()).exist()
+                     || wuya::filestat((archive+".gz").c_str()).exist() );
+            --seq_;
+            ::rename(old.c_str(), archive.c_str());
+        }
+        op_.open(np_.name().c_str());
+        // ׷ӵļʱԭдС
+        wuya::filestat fs(np_.name().c_str());
+        written_ = fs.exist()?(unsigned long)fs.length():0;
+        if( opened_ && archiver_ != 0 ) {
+            archiver_->add(archive, np_.name());
+        }
+        opened_ = true;
     }
 
     inline name_change_policy::name_change_policy(NAME_CHANGE_POLICY np, const std::string& org_name):np_(np),
-        org_name_(org_name),condition_(mutex_),name_changed_(true),lasttime_(wuya::datetime::current_time()){
-        change_name(wuya::datetime::current_time());
-    }
-    inline bool name_change_policy::name_changed(){
-        return name_changed_;
-    }
-    inline void name_change_policy::reset(){
-        name_changed_ = false;
+        org_name_(org_name){
+        change_name(std::time(0));
     }
-    inline std::string name_change_policy::name(){
+
+    inline const std::string& name_change_policy::name() const{
         return name_;
     }
-    inline void name_change_policy::change_name(const wuya::datetime& now){
+
+    inline bool name_change_policy::due(std::time_t now) const{
+        return now >= due_;
+    }
+
+    inline void name_change_policy::change_name(std::time_t now){
+        wuya::datetime dt(now);
         name_ = org_name_;
         std::string::size_type p = name_.find("$DATE");
         if( p!=std::string::npos ) {
-            name_.replace(p, 5, now.date_str());
+            name_.replace(p, 5, dt.date_str());
         }
         p = name_.find("$TIME");
         if( p!=std::string::npos ) {
-            name_.replace(p, 5, now.time_str());
+            name_.replace(p, 5, dt.time_str());
         }
+        due_ = next_due(now);
     }
-    inline void name_change_policy::wait(){
-        wuya::datetime time = lasttime_;
-        int y,m,d;
+
+    inline std::time_t name_change_policy::next_due(std::time_t now) const{
+        tm t;
+#if defined(WIN32)||defined(_WIN32)
+        localtime_s(&t, &now);
+#else
+        localtime_r(&now, &t);
+#endif
+        t.tm_hour = t.tm_min = t.tm_sec = 0;
+        t.tm_isdst = -1;
         switch( np_ ) {
         case DAY_CHANGE:
-            time = time+wuya::timespan(1, 0);
-            y = time.year();
-            m = time.month();
-            d = time.day();
+            ++t.tm_mday;
             break;
         case WEEK_CHANGE:
-            time = time+wuya::timespan(7, 0);
-            y = time.year();
-            m = time.month();
-            d = time.day();
+            t.tm_mday += 7;
             break;
         case MONTH_CHANGE:
-            y = time.year();
-            m = time.month();
-            d = time.day();
-            if( m==12 ) {
-                ++y;
-            } else {
-                ++m;
-            }
+            t.tm_mday = 1;
+            ++t.tm_mon;
+            break;
         case NEVER_CHANGE:
-            return;
+        default:
+            return std::numeric_limits<std::time_t>::max();
+        }
+        // mktime淶Խա
+        return mktime(&t);
+    }
+
+    inline log_queue& log_queue::defaults(){
+        static log_queue cfg = {false, 1024};
+        return cfg;
+    }
+
+    inline log_shard::log_shard(unsigned long size):ring(size),state(ACTIVE){
+    }
+
+    inline log_rotate& log_rotate::defaults(){
+        static log_rotate cfg = {0, 0, false};
+        return cfg;
+    }
+
+    inline log_archiver::log_archiver(const log_rotate& cfg, const std::string& org_name):cfg_(cfg),
+        exit_(false),condition_(mutex_){
+        wuya::filestat fs(org_name.c_str());
+        dir_ = fs.get_filepath();
+        if( dir_.empty() ) {
+            dir_ = ".";
+        }
+        matcher_ = fs.get_filename();
+        const char* vars[] = {"$DATE", "$TIME"};
+        for( int i=0; i<2; ++i ) {
+            std::string::size_type p = matcher_.find(vars[i]);
+            if( p!=std::string::npos ) {
+                matcher_.replace(p, 5, "*");
+            }
         }
-        time.set(y, m, d);
-        long time_to_sleep = (time-lasttime_).get_total_seconds();
+        // ƥʱӵʱ׺.gz
+        matcher_ += "*";
+        ACE_Thread_Manager::instance()->spawn((ACE_THR_FUNC)thr_archive, (void*)this, THR_NEW_LWP | THR_JOINABLE
+                                              | THR_INHERIT_SCHED, &thread_id_);
+    }
+
+    inline log_archiver::~log_archiver(){
         {
             ACE_GUARD(ACE_Thread_Mutex, guard, mutex_);
-            ACE_Time_Value t(time_to_sleep);
-            t += ACE_OS::gettimeofday();
-            condition_.wait(&t);
+            exit_ = true;
+            condition_.signal();
+        }
+        ACE_Thread_Manager::instance()->join(thread_id_);
+    }
+
+    inline void log_archiver::add(const std::string& file, const std::string& current){
+        ACE_GUARD(ACE_Thread_Mutex, guard, mutex_);
+        files_.push_back(std::make_pair(file, current));
+        condition_.signal();
+    }
+
+    inline void log_archiver::thr_archive(void* data){
+        ((log_archiver*)data)->archive();
+    }
+
+    inline void log_archiver::archive(){
+        while( true ) {
+            std::pair<std::string, std::string> job;
+            {
+                ACE_GUARD(ACE_Thread_Mutex, guard, mutex_);
+                while( files_.empty() && !exit_ ) {
+                    condition_.wait();
+                }
+                // ˳ǰеļ
+                if( files_.empty() ) {
+                    return;
+                }
+                job = files_.front();
+                files_.pop_front();
+            }
+            if( cfg_.compress ) {
+                compress(job.first);
+            }
+            if( cfg_.max_files > 0 ) {
+                prune(job.second);
+            }
+        }
+    }
+
+    inline bool log_archiver::compress(const std::string& file){
+        // ѹʱļѱpruneɾ
+        if( !wuya::filestat(file.c_str()).exist() ) {
+            return false;
+        }
+#ifdef WUYA_LOG_USE_ZLIB
+        FILE* in = fopen(file.c_str(), "rb");
+        if( in == 0 ) {
+            return false;
+        }
+        gzFile out = gzopen((file+".gz").c_str(), "wb");
+        if( out == 0 ) {
+            fclose(in);
+            return false;
+        }
+        char buf[65536];
+        size_t n;
+        bool ok = true;
+        while( ok && (n = fread(buf, 1, sizeof buf, in)) > 0 ) {
+            ok = gzwrite(out, buf, (unsigned)n) == (int)n;
+        }
+        fclose(in);
+        ok = gzclose(out) == Z_OK && ok;
+        if( ok ) {
+            remove_file(file.c_str());
+        } else {
+            remove_file((file+".gz").c_str());
+        }
+        return ok;
+#else
+        // ڶ̵߳־еⲿûzlibʱԭļ
+        return false;
+#endif
+    }
+
+    inline log_archiver::collector::collector(std::vector<std::string>& files):files_(files){
+    }
+
+    inline void log_archiver::collector::operator()(const char* filename){
+        files_.push_back(filename);
+    }
+
+    inline void log_archiver::prune(const std::string& current){
+        std::vector<std::string> files;
+        wuya::filefind ff(dir_.c_str(), matcher_.c_str());
+        ff.scan(collector(files));
+        wuya::filestat cur(current.c_str());
+        std::string cur_name = cur.get_filename();
+        std::vector<std::string> archives;
+        for( size_t i=0; i<files.size(); ++i ) {
+            if( wuya::filestat(files[i].c_str()).get_filename() != cur_name ) {
+                archives.push_back(files[i]);
+            }
+        }
+        // ļеʱʹֵΪʱ˳
+        std::sort(archives.begin(), archives.end());
+        for( size_t i=0; i+(size_t)cfg_.max_files<archives.size(); ++i ) {
+            remove_file(archives[i].c_str());
         }
     }
 
@@ -339,30 +1778,135 @@ namespace wuya {
         std::cout << msg;
         return true;
     }
+    inline bool cout_output_type::flush(bool force){
+        std::cout.flush();
+        return true;
+    }
+    inline bool cout_output_type::sync(){
+        return flush(true);
+    }
+    inline bool cout_output_type::pending() const{
+        return false;
+    }
+    inline int cout_output_type::flush_interval() const{
+        return 0;
+    }
     inline bool cout_output_type::open(const char* name){
         return true;
     }
     inline void cout_output_type::close(){
     }
 
+    inline file_output_type::config& file_output_type::defaults(){
+        static config cfg = {64*1024, 0, false};
+        return cfg;
+    }
+
+    inline file_output_type::file_output_type():fd_(-1),cfg_(defaults()),last_flush_(0){
+        buf_.reserve(cfg_.flush_bytes*2);
+    }
+
+    inline file_output_type::~file_output_type(){
+        close();
+    }
+
     inline bool file_output_type::write(const std::string& msg){
-        if(stream_) {
-            stream_ << msg;
-            stream_.flush();
+        if( fd_ < 0 ) {
+            return false;
+        }
+        buf_.append(msg);
+        if( buf_.size() >= cfg_.flush_bytes ) {
+            return flush(true);
+        }
+        return true;
+    }
+
+    inline bool file_output_type::flush(bool force){
+        if( buf_.empty() || fd_ < 0 ) {
             return true;
         }
-        return false;
+        long long t = now_msec();
+        if( !force && t-last_flush_ < cfg_.flush_interval ) {
+            return true;
+        }
+        last_flush_ = t;
+        bool ret = write_all(buf_.data(), buf_.size());
+        buf_.clear();
+        if( cfg_.fsync ) {
+            sync_file();
+        }
+        return ret;
+    }
+
+    inline bool file_output_type::sync(){
+        bool ret = flush(true);
+        if( fd_ >= 0 && !cfg_.fsync ) {
+            sync_file();
+        }
+        return ret;
+    }
+
+    inline void file_output_type::sync_file(){
+#if defined(WIN32)||defined(_WIN32)
+        _commit(fd_);
+#else
+        ::fsync(fd_);
+#endif
+    }
+
+    inline bool file_output_type::pending() const{
+        return !buf_.empty();
+    }
+
+    inline int file_output_type::flush_interval() const{
+        return cfg_.flush_interval;
+    }
+
+    inline bool file_output_type::write_all(const char* buf, size_t len){
+        while( len > 0 ) {
+#if defined(WIN32)||defined(_WIN32)
+            int n = ::_write(fd_, buf, (unsigned int)len);
+#else
+            ssize_t n = ::write(fd_, buf, len);
+            if( n < 0 && errno == EINTR ) {
+                continue;
+            }
+#endif
+            if( n <= 0 ) {
+                return false;
+            }
+            buf += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    // ʱӣϵͳʱ䲻Ӱдļ
+    inline long long file_output_type::now_msec(){
+        static const long long per_msec = log_clock::ticks_per_sec()/1000;
+        return per_msec>0?log_clock::ticks()/per_msec:log_clock::ticks()*1000/log_clock::ticks_per_sec();
     }
 
     inline bool file_output_type::open(const char* name){
-        stream_.clear();
-        stream_.open(name, std::ios_base::out|std::ios_base::app);
-        return stream_.good();
+        close();
+#if defined(WIN32)||defined(_WIN32)
+        fd_ = ::_open(name, _O_WRONLY|_O_CREAT|_O_APPEND|_O_BINARY, _S_IREAD|_S_IWRITE);
+#else
+        fd_ = ::open(name, O_WRONLY|O_CREAT|O_APPEND, 0644);
+#endif
+        last_flush_ = now_msec();
+        return fd_ >= 0;
     }
 
     inline void file_output_type::close(){
-        if(stream_.is_open()) {
-            stream_.close();
+        if( fd_ >= 0 ) {
+            flush(true);
+#if defined(WIN32)||defined(_WIN32)
+            ::_close(fd_);
+#else
+            ::close(fd_);
+#endif
+            fd_ = -1;
         }
     }
 
@@ -7,6 +7,8 @@
 #include <ace/Thread_Mutex.h>
 #include <ace/Condition_T.h>
 #include <ace/Guard_T.h>
+#include <wuya/trace.h>
+#include <wuya/histogram.h>
 
 namespace wuya{
 	/**
@@ -45,6 +47,10 @@ namespace wuya{
 		ACE_SOCK_Stream* get_connect(const char* peer_addr=0);
 		void close(ACE_SOCK_Stream* conn);
 		void disconnect(ACE_SOCK_Stream* conn);
+		/**
+		 * get_connectĵȴʱ䣨룩ȴʱΪ0
+		 */
+		const histogram<>& wait_time() const;
 		/**
 		 * call before system exit, you should not call it since system will call it
 		 */
@@ -65,6 +71,7 @@ namespace wuya{
 	private:
 		ACE_Thread_Mutex mutex_;
 		ACE_Thread_Condition<ACE_Thread_Mutex> condition_;
+		histogram<> wait_time_;
 	private:
 		sock_pool();
 		sock_pool(const sock_pool& src);
@@ -148,15 +155,23 @@ namespace wuya{
 		ACE_Guard<ACE_Thread_Mutex> guard(mutex_);
 		guard;
 		if (available_ != 0) {
+			wait_time_.record(0);
 			return get_connect_i(peer_addr);
 		} else {
+			WUYA_TRACE_SCOPE_CAT("pool", "sock_pool wait");
+			mono_timer t(true);
 			while (available_ == 0) {
 				condition_.wait();
 			}
+			wait_time_.record(t.elapsed_ns());
 			return get_connect_i(peer_addr);
 		}
 	}
 
+	inline const histogram<>& sock_pool::wait_time() const {
+		return wait_time_;
+	}
+
 	inline unsigned char sock_pool::get_id(ACE_SOCK_Stream* conn) {
 		return(unsigned char)(conn-ptr_);
 	}
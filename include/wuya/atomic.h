@@ -0,0 +1,128 @@
+#ifndef __WUYA_ATOMIC_H__
+#define __WUYA_ATOMIC_H__
+
+#if defined(_MSC_VER)
+	#define _WINSOCKAPI_
+	#include <windows.h>
+	#include <intrin.h>
+#elif defined(__i386__) || defined(__x86_64__)
+	#include <xmmintrin.h>
+#endif
+
+namespace wuya{
+	/**
+	 * ԭӲݽṹ
+	 * gcc/clangʹ__atomicڽVCʹInterlockedϵк
+	 *
+	 * @author wuya
+	 */
+	// acquire
+	long atomic_load(const volatile long* p);
+	// дrelease
+	void atomic_store(volatile long* p, long v);
+	// vӺֵ
+	long atomic_add(volatile long* p, long v);
+	// *pexpectedΪdesiredɹtrue
+	bool atomic_cas(volatile long* p, long expected, long desired);
+	// Ϊvԭֵ
+	long atomic_exchange(volatile long* p, long v);
+	// 64λ汾32λƽ̨ͬԭӵģڼʱ
+	long long atomic_load(const volatile long long* p);
+	void atomic_store(volatile long long* p, long long v);
+	long long atomic_add(volatile long long* p, long long v);
+	bool atomic_cas(volatile long long* p, long long expected, long long desired);
+	long long atomic_exchange(volatile long long* p, long long v);
+	// ȫڴ
+	void atomic_fence();
+	// ȴʱCPUռ
+	void cpu_relax();
+}
+
+//.............................ʵֲ.............................//
+namespace wuya{
+#if defined(_MSC_VER)
+	inline long atomic_load(const volatile long* p) {
+		long v = *p;
+		_ReadWriteBarrier();
+		return v;
+	}
+	inline void atomic_store(volatile long* p, long v) {
+		_ReadWriteBarrier();
+		*p = v;
+	}
+	inline long atomic_add(volatile long* p, long v) {
+		return InterlockedExchangeAdd(p, v)+v;
+	}
+	inline bool atomic_cas(volatile long* p, long expected, long desired) {
+		return InterlockedCompareExchange(p, desired, expected) == expected;
+	}
+	inline long atomic_exchange(volatile long* p, long v) {
+		return InterlockedExchange(p, v);
+	}
+	inline long long atomic_load(const volatile long long* p) {
+		// 32λƽ̨CAS֤8ֽڶԭ
+		return InterlockedCompareExchange64((volatile LONGLONG*)p, 0, 0);
+	}
+	inline void atomic_store(volatile long long* p, long long v) {
+		InterlockedExchange64(p, v);
+	}
+	inline long long atomic_add(volatile long long* p, long long v) {
+		return InterlockedExchangeAdd64(p, v)+v;
+	}
+	inline bool atomic_cas(volatile long long* p, long long expected, long long desired) {
+		return InterlockedCompareExchange64(p, desired, expected) == expected;
+	}
+	inline long long atomic_exchange(volatile long long* p, long long v) {
+		return InterlockedExchange64(p, v);
+	}
+	inline void atomic_fence() {
+		MemoryBarrier();
+	}
+	inline void cpu_relax() {
+		YieldProcessor();
+	}
+#else
+	inline long atomic_load(const volatile long* p) {
+		return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+	}
+	inline void atomic_store(volatile long* p, long v) {
+		__atomic_store_n(p, v, __ATOMIC_RELEASE);
+	}
+	inline long atomic_add(volatile long* p, long v) {
+		return __atomic_add_fetch(p, v, __ATOMIC_SEQ_CST);
+	}
+	inline bool atomic_cas(volatile long* p, long expected, long desired) {
+		return __atomic_compare_exchange_n(p, &expected, desired, false,
+										   __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+	}
+	inline long atomic_exchange(volatile long* p, long v) {
+		return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST);
+	}
+	inline long long atomic_load(const volatile long long* p) {
+		return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+	}
+	inline void atomic_store(volatile long long* p, long long v) {
+		__atomic_store_n(p, v, __ATOMIC_RELEASE);
+	}
+	inline long long atomic_add(volatile long long* p, long long v) {
+		return __atomic_add_fetch(p, v, __ATOMIC_SEQ_CST);
+	}
+	inline bool atomic_cas(volatile long long* p, long long expected, long long desired) {
+		return __atomic_compare_exchange_n(p, &expected, desired, false,
+										   __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+	}
+	inline long long atomic_exchange(volatile long long* p, long long v) {
+		return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST);
+	}
+	inline void atomic_fence() {
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	}
+	inline void cpu_relax() {
+	#if defined(__i386__) || defined(__x86_64__)
+		_mm_pause();
+	#endif
+	}
+#endif
+}
+
+#endif
@@ -0,0 +1,866 @@
+#ifndef __WUYA_BINLOG_H__
+#define __WUYA_BINLOG_H__
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <map>
+#include <vector>
+#include <fstream>
+#include <wuya/ace_log.h>
+
+#if !defined(WUYA_SNPRINTF)
+	#if defined(_MSC_VER)
+		#define WUYA_SNPRINTF _snprintf
+	#else
+		#define WUYA_SNPRINTF snprintf
+	#endif
+#endif
+
+namespace wuya{
+	/**
+	 * ־
+	 * д־ֻ߳¼õšʱͲԭʼֽڣʽƳٵ߳
+	 * binlog_text_output߹ߣbinlog_decodertools/binlog2text.cpp
+	 * ¼logger<Op_>Ķдݣı־öСԺļԡ
+	 *
+	 * ÷
+	 *   #define BINLOGSTREAM logstream<binlog_output_type>
+	 *   BINLOGSTREAM::init(NEVER_CHANGE, "log/app.blog");
+	 *   bininfo_cout("recv %d bytes from %s") << n << peer;
+	 *
+	 * ļΪֽֽͬĻϽ롣
+	 *
+	 * @author wuya
+	 */
+
+	// ¼
+	enum BINLOG_RECORD_TYPE {
+		// һ־ãΪ
+		BINLOG_EVENT = 1,
+		// õ㶨壬Ϊкšļʽ
+		BINLOG_SITE = 2,
+		// ԭıloggerʾ
+		BINLOG_TEXT = 3,
+		// ÿδļʱд룬֮ǰĵõ㶨
+		BINLOG_BEGIN = 4
+	};
+
+	// ͱ
+	enum BINLOG_ARG_TYPE {
+		BINARG_INT = 'i',
+		BINARG_UINT = 'u',
+		BINARG_DOUBLE = 'd',
+		BINARG_CHAR = 'c',
+		BINARG_STRING = 's',
+		BINARG_PTR = 'p'
+	};
+
+	/**
+	 * ¼ͷΪݣдʱmemcpyҪ
+	 */
+	struct binlog_header {
+		unsigned char type;
+		unsigned char level;
+		// ¼ֽ¼ͷ
+		unsigned short size;
+		// õ
+		unsigned int site;
+		// 1970΢
+		long long usec;
+	};
+
+	/**
+	 * õ㣬ɺ궨Ϊ̬󣬳ʼ
+	 */
+	struct binlog_site {
+		const char* fmt;
+		const char* file;
+		int line;
+		int level;
+		// 0ΪδǼǣ-1ΪڵǼ
+		volatile long id;
+	};
+
+	/**
+	 * õǼǱõ״ִʱ
+	 */
+	class binlog_registry {
+	public:
+		enum { MAX_SITES = 16384 };
+		// ȡõõţMAX_SITESʱ0
+		static long id(binlog_site& site);
+		// ȡõ
+		static const binlog_site* get(long id);
+	private:
+		static binlog_site** sites();
+		static volatile long& count();
+	};
+
+	/**
+	 * 룬ÿΪһֽͱǼԭʼֽڣMAX_SIZEĲַض
+	 */
+	class binlog_args {
+	public:
+		enum { MAX_SIZE = 256 };
+		explicit binlog_args(binlog_site& site);
+	public:
+		binlog_args& operator<<(bool v);
+		binlog_args& operator<<(char v);
+		binlog_args& operator<<(signed char v);
+		binlog_args& operator<<(unsigned char v);
+		binlog_args& operator<<(short v);
+		binlog_args& operator<<(unsigned short v);
+		binlog_args& operator<<(int v);
+		binlog_args& operator<<(unsigned int v);
+		binlog_args& operator<<(long v);
+		binlog_args& operator<<(unsigned long v);
+		binlog_args& operator<<(long long v);
+		binlog_args& operator<<(unsigned long long v);
+		binlog_args& operator<<(float v);
+		binlog_args& operator<<(double v);
+		binlog_args& operator<<(const char* v);
+		binlog_args& operator<<(const std::string& v);
+		binlog_args& operator<<(const void* v);
+	protected:
+		void put(char tag, const void* p, size_t n);
+		void put_string(const char* s, size_t n);
+
+		char buf_[MAX_SIZE];
+		size_t size_;
+		int level_;
+	private:
+		binlog_args(const binlog_args& );
+		binlog_args& operator=(const binlog_args& );
+	};
+
+	/**
+	 * һ־ãʱѼ¼stream_type־
+	 */
+	template<class stream_type>
+	class binlog_record : public binlog_args {
+	public:
+		explicit binlog_record(binlog_site& site);
+		~binlog_record();
+	};
+
+	/**
+	 * printfʽʽÿת˵ȡһʵڳη
+	 * ת˵ʱĩβʱ"<?>"֧*ָȻ򾫶ȡ
+	 */
+	void binlog_format(const char* fmt, const char* args, size_t len, std::string& out);
+	// ı־ĸʽ׷һУʱ䡢Ϣ
+	void binlog_format_line(int level, long long usec, const char* fmt, const char* args,
+							size_t len, std::string& out);
+
+	/**
+	 * ļÿδļʱдBINLOG_BEGIN
+	 * õڱļ״γʱд䶨
+	 */
+	class binlog_output_type {
+	public:
+		binlog_output_type();
+		bool write(const std::string& msg);
+		bool flush(bool force=true);
+		bool sync();
+		bool pending() const;
+		int flush_interval() const;
+		bool open(const char* name);
+		void close();
+	private:
+		void write_site(long id);
+
+		file_output_type file_;
+		std::string rec_;
+		std::vector<bool> defined_;
+	};
+
+	/**
+	 * ߳аѼ¼ʽΪıٽOp_ı־ͬ
+	 */
+	template<class Op_>
+	class binlog_text_output {
+	public:
+		bool write(const std::string& msg);
+		bool flush(bool force=true);
+		bool sync();
+		bool pending() const;
+		int flush_interval() const;
+		bool open(const char* name);
+		void close();
+	private:
+		Op_ op_;
+		std::string line_;
+	};
+
+	/**
+	 * ־ļ
+	 */
+	class binlog_decoder {
+	public:
+		binlog_decoder();
+		bool open(const char* name);
+		void close();
+		/**
+		 * һ־תΪıУз
+		 *
+		 * @return ļʽʱfalseerror()
+		 */
+		bool next(std::string& line);
+		bool error() const;
+	private:
+		/**
+		 * һ¼
+		 *
+		 * @return ıʱtrue
+		 */
+		bool decode(const char* rec, size_t len, std::string& line);
+
+		struct site_def {
+			int level;
+			std::string fmt;
+		};
+		std::map<unsigned int, site_def> sites_;
+		std::ifstream in_;
+		std::string rec_;
+		bool error_;
+	};
+}
+
+#ifndef BINLOGSTREAM
+	#define BINLOGSTREAM wuya::logstream<wuya::binlog_output_type>
+#endif
+
+// ı־ͬļˣõΪʼľ̬״ִʱŷ
+#define WUYA_BINLOG(level, cond, fmt) \
+	for( bool wuya_binlog_once_ = !((level) > WUYA_LOG_MIN_LEVEL || !(cond)); wuya_binlog_once_; wuya_binlog_once_ = false ) \
+	for( static wuya::binlog_site wuya_binlog_site_ = {fmt, __FILE__, __LINE__, level, 0}; \
+		 wuya_binlog_once_; wuya_binlog_once_ = false ) \
+		wuya::binlog_record<BINLOGSTREAM >(wuya_binlog_site_)
+
+#define binerr_cout(fmt) WUYA_BINLOG(wuya::LOG_ERROR, wuya::log_module::global_enabled(wuya::LOG_ERROR), fmt)
+#define binwarn_cout(fmt) WUYA_BINLOG(wuya::LOG_WARN, wuya::log_module::global_enabled(wuya::LOG_WARN), fmt)
+#define bininfo_cout(fmt) WUYA_BINLOG(wuya::LOG_INFO, wuya::log_module::global_enabled(wuya::LOG_INFO), fmt)
+#define bindbg_cout(fmt) WUYA_BINLOG(wuya::LOG_DEBUG, wuya::log_module::global_enabled(wuya::LOG_DEBUG), fmt)
+
+//.............................ʵֲ.............................//
+namespace wuya{
+	inline binlog_site** binlog_registry::sites() {
+		static binlog_site* s[MAX_SITES];
+		return s;
+	}
+
+	inline volatile long& binlog_registry::count() {
+		static volatile long n = 0;
+		return n;
+	}
+
+	inline long binlog_registry::id(binlog_site& site) {
+		long id = atomic_load(&site.id);
+		if (id > 0) {
+			return id<MAX_SITES?id:0;
+		}
+		if (id == 0 && atomic_cas(&site.id, 0, -1)) {
+			id = atomic_add(&count(), 1);
+			if (id < MAX_SITES) {
+				sites()[id] = &site;
+			} else {
+				id = MAX_SITES;
+			}
+			// release屣֤߳̿ʱǼǱд
+			atomic_store(&site.id, id);
+		}
+		while ((id = atomic_load(&site.id)) < 0) {
+			cpu_relax();
+		}
+		return id<MAX_SITES?id:0;
+	}
+
+	inline const binlog_site* binlog_registry::get(long id) {
+		return(id>0 && id<MAX_SITES)?sites()[id]:0;
+	}
+
+	inline binlog_args::binlog_args(binlog_site& site):size_(sizeof(binlog_header)),level_(site.level) {
+		binlog_header h;
+		h.type = BINLOG_EVENT;
+		h.level = (unsigned char)site.level;
+		h.size = 0;
+		h.site = (unsigned int)binlog_registry::id(site);
+		std::time_t sec;
+		long usec;
+		log_clock::now(sec, usec);
+		h.usec = (long long)sec*1000000+usec;
+		memcpy(buf_, &h, sizeof h);
+	}
+
+	inline void binlog_args::put(char tag, const void* p, size_t n) {
+		if (size_+1+n > MAX_SIZE) {
+			return;
+		}
+		buf_[size_++] = tag;
+		memcpy(buf_+size_, p, n);
+		size_ += n;
+	}
+
+	inline void binlog_args::put_string(const char* s, size_t n) {
+		if (size_+3 > MAX_SIZE) {
+			return;
+		}
+		if (n > MAX_SIZE-size_-3) {
+			n = MAX_SIZE-size_-3;
+		}
+		unsigned short len = (unsigned short)n;
+		buf_[size_++] = BINARG_STRING;
+		memcpy(buf_+size_, &len, sizeof len);
+		memcpy(buf_+size_+sizeof len, s, n);
+		size_ += sizeof len+n;
+	}
+
+	inline binlog_args& binlog_args::operator<<(bool v) {
+		long long i = v;
+		put(BINARG_INT, &i, sizeof i);
+		return *this;
+	}
+
+	inline binlog_args& binlog_args::operator<<(char v) {
+		long long i = v;
+		put(BINARG_CHAR, &i, sizeof i);
+		return *this;
+	}
+
+	inline binlog_args& binlog_args::operator<<(signed char v) {
+		long long i = v;
+		put(BINARG_CHAR, &i, sizeof i);
+		return *this;
+	}
+
+	inline binlog_args& binlog_args::operator<<(unsigned char v) {
+		long long i = v;
+		put(BINARG_CHAR, &i, sizeof i);
+		return *this;
+	}
+
+	inline binlog_args& binlog_args::operator<<(short v) {
+		long long i = v;
+		put(BINARG_INT, &i, sizeof i);
+		return *this;
+	}
+
+	inline binlog_args& binlog_args::operator<<(unsigned short v) {
+		long long i = v;
+		put(BINARG_UINT, &i, sizeof i);
+		return *this;
+	}
+
+	inline binlog_args& binlog_args::operator<<(int v) {
+		long long i = v;
+		put(BINARG_INT, &i, sizeof i);
+		return *this;
+	}
+
+	inline binlog_args& binlog_args::operator<<(unsigned int v) {
+		long long i = v;
+		put(BINARG_UINT, &i, sizeof i);
+		return *this;
+	}
+
+	inline binlog_args& binlog_args::operator<<(long v) {
+		long long i = v;
+		put(BINARG_INT, &i, sizeof i);
+		return *this;
+	}
+
+	inline binlog_args& binlog_args::operator<<(unsigned long v) {
+		unsigned long long i = v;
+		put(BINARG_UINT, &i, sizeof i);
+		return *this;
+	}
+
+	inline binlog_args& binlog_args::operator<<(long long v) {
+		put(BINARG_INT, &v, sizeof v);
+		return *this;
+	}
+
+	inline binlog_args& binlog_args::operator<<(unsigned long long v) {
+		put(BINARG_UINT, &v, sizeof v);
+		return *this;
+	}
+
+	inline binlog_args& binlog_args::operator<<(float v) {
+		double d = v;
+		put(BINARG_DOUBLE, &d, sizeof d);
+		return *this;
+	}
+
+	inline binlog_args& binlog_args::operator<<(double v) {
+		put(BINARG_DOUBLE, &v, sizeof v);
+		return *this;
+	}
+
+	inline binlog_args& binlog_args::operator<<(const char* v) {
+		if (v == 0) {
+			v = "(null)";
+		}
+		put_string(v, strlen(v));
+		return *this;
+	}
+
+	inline binlog_args& binlog_args::operator<<(const std::string& v) {
+		put_string(v.data(), v.size());
+		return *this;
+	}
+
+	inline binlog_args& binlog_args::operator<<(const void* v) {
+		unsigned long long i = (unsigned long long)(size_t)v;
+		put(BINARG_PTR, &i, sizeof i);
+		return *this;
+	}
+
+	template<class stream_type>
+	inline binlog_record<stream_type>::binlog_record(binlog_site& site):binlog_args(site) {
+	}
+
+	template<class stream_type>
+	inline binlog_record<stream_type>::~binlog_record() {
+		binlog_header h;
+		memcpy(&h, buf_, sizeof h);
+		if (h.site == 0) {
+			return;
+		}
+		unsigned short size = (unsigned short)size_;
+		memcpy(buf_+offsetof(binlog_header, size), &size, sizeof size);
+		stream_type::submit(buf_, size_, (LOGLEVEL)level_);
+	}
+
+	/**
+	 * ʱһ
+	 */
+	struct binlog_arg {
+		char tag;
+		long long i;
+		double d;
+		const char* s;
+		size_t n;
+	};
+
+	// һûвݲʱfalse
+	inline bool binlog_read_arg(const char*& p, const char* end, binlog_arg& a) {
+		if (p >= end) {
+			return false;
+		}
+		a.tag = *p++;
+		if (a.tag == BINARG_STRING) {
+			unsigned short len;
+			if (end-p < (long)sizeof len) {
+				return false;
+			}
+			memcpy(&len, p, sizeof len);
+			p += sizeof len;
+			if (end-p < (long)len) {
+				return false;
+			}
+			a.s = p;
+			a.n = len;
+			p += len;
+			return true;
+		}
+		if (end-p < 8) {
+			return false;
+		}
+		if (a.tag == BINARG_DOUBLE) {
+			memcpy(&a.d, p, sizeof a.d);
+		} else {
+			memcpy(&a.i, p, sizeof a.i);
+		}
+		p += 8;
+		return true;
+	}
+
+	/**
+	 * һת˵ʽ
+	 *
+	 * @param spec   ת˵'%'־Ⱥ;Ȳ
+	 * @param conv   תַ0ʾѡ
+	 */
+	inline void binlog_format_arg(const std::string& spec, char conv, const binlog_arg& a, std::string& out) {
+		char tmp[512];
+		std::string f(spec);
+		int r = 0;
+		bool float_conv = conv!=0 && strchr("eEfFgGaA", conv)!=0;
+		bool int_conv = conv!=0 && strchr("diouxX", conv)!=0;
+		if (a.tag == BINARG_STRING) {
+			if (f.size() == 1) {
+				out.append(a.s, a.n);
+				return;
+			}
+			f += 's';
+			r = WUYA_SNPRINTF(tmp, sizeof tmp, f.c_str(), std::string(a.s, a.n).c_str());
+		} else if (a.tag == BINARG_DOUBLE) {
+			if (int_conv) {
+				f += "ll";
+				f += conv;
+				r = WUYA_SNPRINTF(tmp, sizeof tmp, f.c_str(), (long long)a.d);
+			} else {
+				f += float_conv?conv:'g';
+				r = WUYA_SNPRINTF(tmp, sizeof tmp, f.c_str(), a.d);
+			}
+		} else if (float_conv) {
+			f += conv;
+			r = WUYA_SNPRINTF(tmp, sizeof tmp, f.c_str(),
+							  a.tag==BINARG_INT?(double)a.i:(double)(unsigned long long)a.i);
+		} else {
+			if (!int_conv && conv != 'c' && conv != 'p') {
+				// %sȱתַʱ
+				conv = a.tag==BINARG_INT?'d':(a.tag==BINARG_UINT?'u':(a.tag==BINARG_CHAR?'c':'p'));
+			}
+			if (conv == 'c') {
+				f += conv;
+				r = WUYA_SNPRINTF(tmp, sizeof tmp, f.c_str(), (int)a.i);
+			} else if (conv == 'p') {
+				f += conv;
+				r = WUYA_SNPRINTF(tmp, sizeof tmp, f.c_str(), (void*)(size_t)(unsigned long long)a.i);
+			} else {
+				f += "ll";
+				f += conv;
+				if ((conv=='d' || conv=='i') && a.tag != BINARG_UINT) {
+					r = WUYA_SNPRINTF(tmp, sizeof tmp, f.c_str(), a.i);
+				} else {
+					r = WUYA_SNPRINTF(tmp, sizeof tmp, f.c_str(), (unsigned long long)a.i);
+				}
+			}
+		}
+		if (r > 0) {
+			out.append(tmp, r<(int)sizeof tmp?r:(int)sizeof tmp-1);
+		}
+	}
+
+	inline void binlog_format(const char* fmt, const char* args, size_t len, std::string& out) {
+		const char* p = args;
+		const char* end = args+len;
+		binlog_arg a;
+		std::string spec;
+		while (*fmt) {
+			if (*fmt != '%') {
+				const char* q = fmt;
+				while (*q && *q != '%') {
+					++q;
+				}
+				out.append(fmt, q-fmt);
+				fmt = q;
+				continue;
+			}
+			if (fmt[1] == '%') {
+				out += '%';
+				fmt += 2;
+				continue;
+			}
+			spec = *fmt++;
+			while (*fmt && strchr("-+ #0", *fmt)) {
+				spec += *fmt++;
+			}
+			while (*fmt >= '0' && *fmt <= '9') {
+				spec += *fmt++;
+			}
+			if (*fmt == '.') {
+				spec += *fmt++;
+				while (*fmt >= '0' && *fmt <= '9') {
+					spec += *fmt++;
+				}
+			}
+			// ηɲʵ;
+			while (*fmt && strchr("hlLqjzt", *fmt)) {
+				++fmt;
+			}
+			char conv = *fmt;
+			if (conv == 0) {
+				out += spec;
+				break;
+			}
+			++fmt;
+			if (binlog_read_arg(p, end, a)) {
+				binlog_format_arg(spec, conv, a, out);
+			} else {
+				out += "<?>";
+			}
+		}
+		while (binlog_read_arg(p, end, a)) {
+			out += ' ';
+			binlog_format_arg("%", 0, a, out);
+		}
+	}
+
+	inline void binlog_format_line(int level, long long usec, const char* fmt, const char* args,
+								   size_t len, std::string& out) {
+		if (level < LOG_ERROR || level > LOG_DEBUG) {
+			level = LOG_ERROR;
+		}
+		out.append(level_name((LOGLEVEL)level), 8);
+		char buf[log_clock::MAX_LEN+1];
+		int n = log_clock::format(buf, (std::time_t)(usec/1000000), (long)(usec%1000000));
+		buf[n++] = ' ';
+		out.append(buf, n);
+		binlog_format(fmt, args, len, out);
+		out += '\n';
+	}
+
+	inline binlog_output_type::binlog_output_type() {
+		rec_.reserve(binlog_args::MAX_SIZE);
+	}
+
+	inline bool binlog_output_type::write(const std::string& msg) {
+		binlog_header h;
+		if (msg.size() >= sizeof h && msg[0] == BINLOG_EVENT) {
+			memcpy(&h, msg.data(), sizeof h);
+			if (h.site >= defined_.size()) {
+				defined_.resize(h.site+1, false);
+			}
+			if (!defined_[h.site]) {
+				write_site(h.site);
+			}
+			return file_.write(msg);
+		}
+		// loggerıʾ
+		size_t len = msg.size();
+		if (len > 0xffff-sizeof h) {
+			len = 0xffff-sizeof h;
+		}
+		std::time_t sec;
+		long usec;
+		log_clock::now(sec, usec);
+		h.type = BINLOG_TEXT;
+		h.level = LOG_WARN;
+		h.size = (unsigned short)(sizeof h+len);
+		h.site = 0;
+		h.usec = (long long)sec*1000000+usec;
+		rec_.assign((const char*)&h, sizeof h);
+		rec_.append(msg.data(), len);
+		return file_.write(rec_);
+	}
+
+	inline void binlog_output_type::write_site(long id) {
+		const binlog_site* site = binlog_registry::get(id);
+		if (site == 0) {
+			return;
+		}
+		binlog_header h;
+		int line = site->line;
+		size_t file_len = strlen(site->file);
+		size_t fmt_len = strlen(site->fmt);
+		size_t room = 0xffff-sizeof h-sizeof line-2;
+		if (file_len > room/2) {
+			file_len = room/2;
+		}
+		if (fmt_len > room-file_len) {
+			fmt_len = room-file_len;
+		}
+		h.type = BINLOG_SITE;
+		h.level = (unsigned char)site->level;
+		h.size = (unsigned short)(sizeof h+sizeof line+file_len+fmt_len+2);
+		h.site = (unsigned int)id;
+		h.usec = 0;
+		rec_.assign((const char*)&h, sizeof h);
+		rec_.append((const char*)&line, sizeof line);
+		rec_.append(site->file, file_len);
+		rec_ += '\0';
+		rec_.append(site->fmt, fmt_len);
+		rec_ += '\0';
+		file_.write(rec_);
+		defined_[id] = true;
+	}
+
+	inline bool binlog_output_type::flush(bool force) {
+		return file_.flush(force);
+	}
+
+	inline bool binlog_output_type::sync() {
+		return file_.sync();
+	}
+
+	inline bool binlog_output_type::pending() const {
+		return file_.pending();
+	}
+
+	inline int binlog_output_type::flush_interval() const {
+		return file_.flush_interval();
+	}
+
+	inline bool binlog_output_type::open(const char* name) {
+		if (!file_.open(name)) {
+			return false;
+		}
+		defined_.assign(defined_.size(), false);
+		binlog_header h;
+		std::time_t sec;
+		long usec;
+		log_clock::now(sec, usec);
+		h.type = BINLOG_BEGIN;
+		h.level = 0;
+		h.size = (unsigned short)(sizeof h+8);
+		// ʽ汾
+		h.site = 1;
+		h.usec = (long long)sec*1000000+usec;
+		rec_.assign((const char*)&h, sizeof h);
+		rec_.append("WUYABLOG", 8);
+		return file_.write(rec_);
+	}
+
+	inline void binlog_output_type::close() {
+		file_.close();
+	}
+
+	template<class Op_>
+	inline bool binlog_text_output<Op_>::write(const std::string& msg) {
+		binlog_header h;
+		if (msg.size() < sizeof h || msg[0] != BINLOG_EVENT) {
+			return op_.write(msg);
+		}
+		memcpy(&h, msg.data(), sizeof h);
+		const binlog_site* site = binlog_registry::get(h.site);
+		if (site == 0) {
+			return false;
+		}
+		line_.clear();
+		binlog_format_line(h.level, h.usec, site->fmt, msg.data()+sizeof h, msg.size()-sizeof h, line_);
+		return op_.write(line_);
+	}
+
+	template<class Op_>
+	inline bool binlog_text_output<Op_>::flush(bool force) {
+		return op_.flush(force);
+	}
+
+	template<class Op_>
+	inline bool binlog_text_output<Op_>::sync() {
+		return op_.sync();
+	}
+
+	template<class Op_>
+	inline bool binlog_text_output<Op_>::pending() const {
+		return op_.pending();
+	}
+
+	template<class Op_>
+	inline int binlog_text_output<Op_>::flush_interval() const {
+		return op_.flush_interval();
+	}
+
+	template<class Op_>
+	inline bool binlog_text_output<Op_>::open(const char* name) {
+		return op_.open(name);
+	}
+
+	template<class Op_>
+	inline void binlog_text_output<Op_>::close() {
+		op_.close();
+	}
+
+	inline binlog_decoder::binlog_decoder():error_(false) {
+	}
+
+	inline bool binlog_decoder::open(const char* name) {
+		close();
+		in_.open(name, std::ios::in|std::ios::binary);
+		if (!in_) {
+			return false;
+		}
+		// ļBINLOG_BEGINʼ
+		char buf[sizeof(binlog_header)+8];
+		binlog_header h;
+		if (!in_.read(buf, sizeof buf)) {
+			error_ = true;
+			return false;
+		}
+		memcpy(&h, buf, sizeof h);
+		if (h.type != BINLOG_BEGIN || memcmp(buf+sizeof h, "WUYABLOG", 8) != 0) {
+			error_ = true;
+			return false;
+		}
+		in_.seekg(0);
+		return true;
+	}
+
+	inline void binlog_decoder::close() {
+		if (in_.is_open()) {
+			in_.close();
+		}
+		in_.clear();
+		sites_.clear();
+		error_ = false;
+	}
+
+	inline bool binlog_decoder::next(std::string& line) {
+		binlog_header h;
+		while (in_.read((char*)&h, sizeof h)) {
+			if (h.size < sizeof h) {
+				error_ = true;
+				return false;
+			}
+			rec_.assign((const char*)&h, sizeof h);
+			rec_.resize(h.size);
+			// һ¼̱ʱΪļ
+			if (!in_.read(&rec_[sizeof h], h.size-sizeof h)) {
+				return false;
+			}
+			line.clear();
+			if (decode(rec_.data(), rec_.size(), line)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	inline bool binlog_decoder::error() const {
+		return error_;
+	}
+
+	inline bool binlog_decoder::decode(const char* rec, size_t len, std::string& line) {
+		binlog_header h;
+		memcpy(&h, rec, sizeof h);
+		const char* body = rec+sizeof h;
+		size_t body_len = len-sizeof h;
+		switch (h.type) {
+		case BINLOG_BEGIN:
+			sites_.clear();
+			return false;
+		case BINLOG_SITE:
+			{
+				int src_line;
+				if (body_len < sizeof src_line+2) {
+					return false;
+				}
+				// 𻵻ضϵļ¼ûнβ0ֻڼ¼֮ڲ
+				const char* file = body+sizeof src_line;
+				const char* end = body+body_len;
+				const char* file_end = (const char*)memchr(file, '\0', end-file);
+				if (file_end == 0) {
+					return false;
+				}
+				const char* fmt = file_end+1;
+				const char* fmt_end = (const char*)memchr(fmt, '\0', end-fmt);
+				site_def& def = sites_[h.site];
+				def.level = h.level;
+				def.fmt.assign(fmt, fmt_end==0?end:fmt_end);
+			}
+			return false;
+		case BINLOG_TEXT:
+			line.assign(body, body_len);
+			return true;
+		case BINLOG_EVENT:
+			{
+				std::map<unsigned int, site_def>::const_iterator it = sites_.find(h.site);
+				if (it == sites_.end()) {
+					binlog_format_line(h.level, h.usec, "<unknown site>", body, body_len, line);
+				} else {
+					binlog_format_line(h.level, h.usec, it->second.fmt.c_str(), body, body_len, line);
+				}
+			}
+			return true;
+		default:
+			// ʶļ¼
+			return false;
+		}
+	}
+}
+
+#endif
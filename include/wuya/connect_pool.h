@@ -49,6 +49,8 @@
 #include <otlv4.h>
 #include <iostream>
 #include <wuya/ipc.h>
+#include <wuya/trace.h>
+#include <wuya/histogram.h>
 
 namespace wuya {
 	/**
@@ -86,6 +88,10 @@ namespace wuya {
 		otl_connect* get_connect();
 		void revert_connect(otl_connect* conn);
 		void close_connect(otl_connect* conn);
+		/**
+		 * get_connectĵȴʱ䣨룩ȴʱΪ0
+		 */
+		const histogram<>& wait_time() const;
 		/**
 		 * call before system exit
 		 */
@@ -104,6 +110,7 @@ namespace wuya {
 	private:
 		mutex_type* mutex_;
 		condition_type condition_;
+		histogram<> wait_time_;
 	private:
 		conn_pool_t(mutex_type* m);
 		conn_pool_t(const conn_pool_t& src);
@@ -200,15 +207,24 @@ namespace wuya {
 		mutex_guard<m> guard(*mutex_);
 		guard;
 		if( available_ != 0 ) {
+			wait_time_.record(0);
 			return get_connect_i();
 		} else {
+			WUYA_TRACE_SCOPE_CAT("pool", "connect_pool wait");
+			mono_timer t(true);
 			while( available_ == 0 ) {
 				condition_.wait();
 			}
+			wait_time_.record(t.elapsed_ns());
 			return get_connect_i();
 		}
 	}
 
+	template < class m, class c >
+	inline const histogram<>& conn_pool_t<m,c>::wait_time() const {
+		return wait_time_;
+	}
+
 	template < class m, class c >
 	inline unsigned char conn_pool_t<m,c>::get_id(otl_connect* conn) {
 		return(unsigned char)(conn-ptr_);
@@ -2,10 +2,122 @@
 #define __WUYA_DATETIME_H__
 
 #include <ctime>
+#include <cstddef>
 #include <ostream>
 #include <string>
+#include <wuya/tls.h>
+
+// ֧C++11ʱΪconstexprڱʱ䳣
+#ifndef WUYA_CONSTEXPR
+    #if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+        #define WUYA_CONSTEXPR constexpr
+    #else
+        #define WUYA_CONSTEXPR
+    #endif
+#endif
 
 namespace wuya {
+    /**
+     * ֽıʱ䣬datetime::fields()һ
+     */
+    struct datetime_fields {
+        int year;
+        // 1-12
+        int month;
+        // 1-31
+        int day;
+        // 0-23
+        int hour;
+        // 0-59
+        int minute;
+        // 0-59
+        int second;
+        // 1=Sun, 2=Mon, ..., 7=Satget_day_of_weekͬ
+        int day_of_week;
+        // 1-366
+        int day_of_year;
+    };
+
+    // ھ1970-01-01·Ϊ1-12Խʱ˳
+    WUYA_CONSTEXPR long days_from_civil(int year, int month, int day);
+    // days_from_civil
+    void civil_from_days(long days, int& year, int& month, int& day);
+    // ʱ䣨1970-01-01 00:00:00ʱֽΪֶ
+    void civil_fields(long long local, datetime_fields& f);
+    /**
+     * UTCƫʱ̣ѯʱڿã
+     * WUYA_CONSTEXPR std::time_t t = wuya::utc_time(2024, 1, 1, 0, 0, 0, 8*3600);  // ʱ2024-01-01ʱ
+     *
+     * @param offset UTCƫƣ룩Ϊ
+     */
+    WUYA_CONSTEXPR std::time_t utc_time(int year, int month, int day, int hour=0, int minu=0, int sec=0, long offset=0);
+
+    /**
+     * ʱл򣬼POSIX TZе"Mm.w.d/time"
+     */
+    struct tz_rule {
+        WUYA_CONSTEXPR tz_rule(int month=0, int week=0, int weekday=0, long time=7200);
+        // 1-12
+        int month;
+        // 1-55ʾһ
+        int week;
+        // 0=Sun, 1=Mon, ..., 6=Sat
+        int weekday;
+        // ıʱ䣨룩ʼ򰴱׼ʱ䣬ʱ
+        long time;
+    };
+
+    /**
+     * ʽʱ򣺱׼ʱUTCƫƣѡʱƫƺÿл
+     * ϵͳʱTZתֻ㣬ڶ߳ͬʱʹãʺת
+     *
+     *   wuya::time_zone bj(8*3600);
+     *   wuya::time_zone ny;
+     *   ny.parse("EST5EDT,M3.2.0,M11.1.0");
+     *   wuya::datetime_fields f = wuya::datetime(t).fields(ny);
+     *
+     * @author wuya
+     */
+    class time_zone {
+    public:
+        // ̶UTCƫƣ룩ΪȱʡΪUTC
+        WUYA_CONSTEXPR explicit time_zone(long std_offset=0);
+        time_zone(long std_offset, long dst_offset, const tz_rule& dst_start, const tz_rule& dst_end);
+        /**
+         * POSIX TZĸʽã"CST-8""EST5EDT,M3.2.0,M11.1.0""<+0545>-5:45"
+         * ʱûйʱĹM3.2.0,M11.1.0
+         *
+         * @return ʽ󣬻ʹ˲ֵ֧"Jn""n"ʽĹʱfalseʱ޸
+         */
+        bool parse(const char* tz);
+        // tʱUTCƫƣ룩
+        long utc_offset(std::time_t t) const;
+        bool is_dst(std::time_t t) const;
+        /**
+         * ʱӦʱ
+         * ʱʼʱıʱ䰴׼ʱ任㣬ʱظıʱȡ׼ʱһ
+         *
+         * @param local  1970-01-01 00:00:00ʱ
+         */
+        std::time_t to_utc(long long local) const;
+        std::time_t make_time(int year, int month, int day, int hour=0, int minu=0, int sec=0) const;
+        void fields(std::time_t t, datetime_fields& f) const;
+        // ֽnʱ
+        void fields(const std::time_t* t, datetime_fields* f, std::size_t n) const;
+    private:
+        // yearйrıʱ䣨룩
+        static long long transition(int year, const tz_rule& r);
+        static bool parse_name(const char*& p);
+        static bool parse_time(const char*& p, long& seconds);
+        static bool parse_rule(const char*& p, tz_rule& r);
+
+        long std_offset_;
+        long dst_offset_;
+        bool has_dst_;
+        tz_rule start_;
+        tz_rule end_;
+    };
+
     /**
      * ʱ࣬һʱ
      *
@@ -14,21 +126,29 @@ namespace wuya {
      */
     class datetime {
     public:
-        datetime();
+        WUYA_CONSTEXPR datetime();
         // 캯һstd::time_t͵ıֵ
-        datetime(std::time_t t);
+        WUYA_CONSTEXPR datetime(std::time_t t);
         // 캯ֵΪ꣬(1-12)(1-31)ʱ(0-23)(0-59)(0-59)
         // ʱ
         datetime(int year, int month, int day, int hour=0, int minu=0, int sec=0, int dst=0);
         // 캯Ϊ"YYYYMMDDHHMMSS""YYYYMMDD"ַַʱ
         datetime(const char* date_time);
         // 캯,һtime͵ıֵ
-        datetime(const datetime& t);
+        WUYA_CONSTEXPR datetime(const datetime& t);
     public:
         // жǷ
         static bool is_leap_year( int year );
         void set(std::time_t t);
+        /**
+         * ʱãmktimeԽ¡աʱ֡Զλ
+         *
+         * @param dst    mktimetm_isdstͬ0׼ʱ䣬0ʱС0Զжϡ
+         *               ָʵʲʱֻʱʱmktime
+         */
         void set(int year, int month, int day=1, int hour=0, int minu=0, int sec=0, int dst=0);
+        // ʱıʱ
+        void set(int year, int month, int day, int hour, int minu, int sec, const time_zone& tz);
         void set(const char* date_time);
         // formatting using "C" strftime
         std::string format(const char* fmt) const;
@@ -61,6 +181,31 @@ namespace wuya {
         int second() const;
         // õ 1=Sun, 2=Mon, ..., 7=Sat
         int get_day_of_week() const;
+        // һȡֶΣҪֶʱʹ
+        datetime_fields fields() const;
+        // ڸʱµĸֶ
+        datetime_fields fields(const time_zone& tz) const;
+        /**
+         * tʱ̱ʱUTCƫƣ룩Ϊ28800
+         * ÿ̰߳UTCջ棬һβƫͬʱʹͬһƫƣѯֻ輸㣬
+         * localtimeлһֱӵlocaltime
+         * ٶһ֮лһΣ޸TZѻڲ¡
+         */
+        static long utc_offset(std::time_t t);
+    private:
+        enum { OFFSET_CACHE_SIZE = 512 };
+        // ֱӳĻ棬UTCΪ
+        struct offset_cache {
+            long long day[OFFSET_CACHE_SIZE];
+            long offset[OFFSET_CACHE_SIZE];
+            // 0Ϊգ1Ϊ׼ʱ䣬2Ϊʱ
+            unsigned char state[OFFSET_CACHE_SIZE];
+        };
+        static offset_cache& local_cache();
+        // ͬutc_offsetǷʱ
+        static long local_offset(std::time_t t, bool& dst);
+        // localtimeƫ
+        static long system_offset(std::time_t t, bool& dst);
     public:
         // һstd::time_t͵ıֵ
         datetime& operator=(std::time_t t);
@@ -96,12 +241,11 @@ namespace wuya {
         return year % 4 == 0 && year % 100 != 0 || year % 400 == 0;
     }
 
-    inline datetime::datetime():time_(0) {
+    inline WUYA_CONSTEXPR datetime::datetime():time_(0) {
     }
 
     // 캯һstd::time_t͵ıֵ
-    inline datetime::datetime(std::time_t t) {
-        set(t);
+    inline WUYA_CONSTEXPR datetime::datetime(std::time_t t):time_(t) {
     }
 
     // 캯ֵΪ꣬£գʱ֣룬ʱ
@@ -119,65 +263,65 @@ namespace wuya {
     }
 
     inline void datetime::set(int year, int month, int day, int hour, int minu, int sec, int dst) {
-        struct tm atm;
-        atm.tm_year = year - 1900;     // tm_year is 1900 based
-        atm.tm_mon = month-1;          // tm_mon is 0 based
-        atm.tm_mday = day;
-        atm.tm_hour = hour;
-        atm.tm_min = minu;
-        atm.tm_sec = sec;
-        atm.tm_isdst = dst;
-        time_ = std::mktime(&atm);
+        // ·ݹ淶1-12աʱ֡Ȼλ
+        int m = month-1;
+        year += m/12 - (m%12 < 0);
+        month = (m%12+12)%12 + 1;
+        long long local = (long long)days_from_civil(year, month, day)*86400
+            + (long long)hour*3600 + (long long)minu*60 + sec;
+        // ȰlocalUTCƫƣùʱ̵ƫ
+        bool in_dst;
+        long offset = local_offset((std::time_t)local, in_dst);
+        for( int i=0; i<2; ++i ) {
+            long real = local_offset((std::time_t)(local - offset), in_dst);
+            if( real == offset ) {
+                break;
+            }
+            offset = real;
+        }
+        time_ = (std::time_t)(local - offset);
+        // ıʱ䡢dstԶжʱлǰһڣظıʱ䣩mktimeĹ
+        bool exact = local_offset(time_, in_dst) == offset;
+        bool dummy;
+        if( !exact || (dst >= 0 && in_dst != (dst > 0))
+            || (dst < 0 && (local_offset(time_-86400, dummy) != offset || local_offset(time_+86400, dummy) != offset)) ) {
+            struct tm atm;
+            atm.tm_year = year - 1900;     // tm_year is 1900 based
+            atm.tm_mon = month-1;          // tm_mon is 0 based
+            atm.tm_mday = day;
+            atm.tm_hour = hour;
+            atm.tm_min = minu;
+            atm.tm_sec = sec;
+            atm.tm_isdst = dst;
+            time_ = std::mktime(&atm);
+        }
+    }
+
+    inline void datetime::set(int year, int month, int day, int hour, int minu, int sec, const time_zone& tz) {
+        time_ = tz.make_time(year, month, day, hour, minu, sec);
     }
 
     inline void datetime::set(const char* date_time) {
-        struct tm atm;
-        memset(reinterpret_cast<char*>(&atm), 0, sizeof(tm));
-        atm.tm_mday = 1;
-
-        char buf[5];
-        int i = 0;
-        while( *date_time != 0 ) {
-            memset(buf, 0, 5);
-            switch( i ) {
-            case 0:
-                memcpy(buf, date_time, 4);
-                atm.tm_year = atoi(buf)-1900;
-                date_time += 4;
-                break;
-            case 1:
-                memcpy(buf, date_time, 2);
-                atm.tm_mon = atoi(buf) - 1;
-                date_time += 2;
-                break;
-            case 2:
-                memcpy(buf, date_time, 2);
-                atm.tm_mday = atoi(buf);
-                date_time += 2;
-                break;
-            case 3:
-                memcpy(buf, date_time, 2);
-                atm.tm_hour = atoi(buf);
-                date_time += 2;
-                break;
-            case 4:
-                memcpy(buf, date_time, 2);
-                atm.tm_min = atoi(buf);
-                date_time += 2;
-                break;
-            case 5:
-                memcpy(buf, date_time, 2);
-                atm.tm_sec = atoi(buf);
-                date_time += 2;
+        // Ϊ(4λ)¡աʱ֡(2λ)ȱٵֶȡСֵatoiͬʱֶν
+        static const int width[6] = { 4, 2, 2, 2, 2, 2 };
+        int v[6] = { 1900, 1, 1, 0, 0, 0 };
+        for( int i=0; i<6 && *date_time != 0; ++i ) {
+            int n = 0;
+            bool digit = true;
+            for( int k=0; k<width[i] && *date_time != 0; ++k, ++date_time ) {
+                if( digit && *date_time >= '0' && *date_time <= '9' ) {
+                    n = n*10 + (*date_time-'0');
+                } else {
+                    digit = false;
+                }
             }
-            ++i;
+            v[i] = n;
         }
-        time_ = std::mktime(&atm);
+        set(v[0], v[1], v[2], v[3], v[4], v[5]);
     }
 
     // 캯,һtime͵ıֵ
-    inline datetime::datetime(const datetime& t) {
-        time_ = t.time_;
+    inline WUYA_CONSTEXPR datetime::datetime(const datetime& t):time_(t.time_) {
     }
 
     // һstd::time_t͵ıֵ
@@ -200,81 +344,336 @@ namespace wuya {
         return time_!= -1;
     }
 
-    // õ
-    inline int datetime::year() const {
+    namespace detail {
+        // 3Ϊһ֮ʼĩHoward Hinnant㷨C++11constexprֻһreturnʲ
+        inline WUYA_CONSTEXPR long civil_era(long y) {
+            return (y >= 0 ? y : y-399) / 400;
+        }
+
+        inline WUYA_CONSTEXPR long civil_day_of_era(long yoe, long doy) {
+            return yoe*365 + yoe/4 - yoe/100 + doy;                // [0, 146096]
+        }
+
+        inline WUYA_CONSTEXPR long civil_days(long y, int month, int day) {
+            return civil_era(y)*146097
+                + civil_day_of_era(y - civil_era(y)*400, (153*(month > 2 ? month-3 : month+9) + 2)/5 + day-1)
+                - 719468;
+        }
+    }
+
+    inline WUYA_CONSTEXPR long days_from_civil(int year, int month, int day) {
+        return detail::civil_days((long)year - (month <= 2), month, day);
+    }
+
+    inline void civil_from_days(long days, int& year, int& month, int& day) {
+        long z = days + 719468;
+        long era = (z >= 0 ? z : z-146096) / 146097;
+        long doe = z - era*146097;                                 // [0, 146096]
+        long yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;  // [0, 399]
+        long doy = doe - (365*yoe + yoe/4 - yoe/100);              // [0, 365]
+        long mp = (5*doy + 2)/153;                                 // [0, 11]
+        day = (int)(doy - (153*mp+2)/5 + 1);
+        month = (int)(mp < 10 ? mp+3 : mp-9);
+        year = (int)(yoe + era*400 + (month <= 2));
+    }
+
+    inline void civil_fields(long long local, datetime_fields& f) {
+        long long days = local/86400;
+        long long secs = local%86400;
+        if( secs < 0 ) {
+            secs += 86400;
+            --days;
+        }
+        civil_from_days((long)days, f.year, f.month, f.day);
+        f.hour = (int)(secs/3600);
+        f.minute = (int)(secs/60%60);
+        f.second = (int)(secs%60);
+        // 1970-01-01
+        long w = (long)((days+4)%7);
+        f.day_of_week = (int)(w<0?w+7:w) + 1;
+        f.day_of_year = (int)(days - days_from_civil(f.year, 1, 1)) + 1;
+    }
+
+    inline WUYA_CONSTEXPR std::time_t utc_time(int year, int month, int day, int hour, int minu, int sec, long offset) {
+        return (std::time_t)((long long)days_from_civil(year, month, day)*86400
+            + (long long)hour*3600 + (long long)minu*60 + sec - offset);
+    }
+
+    inline WUYA_CONSTEXPR tz_rule::tz_rule(int month, int week, int weekday, long time)
+        :month(month),week(week),weekday(weekday),time(time) {
+    }
+
+    inline WUYA_CONSTEXPR time_zone::time_zone(long std_offset)
+        :std_offset_(std_offset),dst_offset_(std_offset),has_dst_(false),start_(),end_() {
+    }
+
+    inline time_zone::time_zone(long std_offset, long dst_offset, const tz_rule& dst_start, const tz_rule& dst_end)
+        :std_offset_(std_offset),dst_offset_(dst_offset),has_dst_(true),start_(dst_start),end_(dst_end) {
+    }
+
+    inline long long time_zone::transition(int year, const tz_rule& r) {
+        long first = days_from_civil(year, r.month, 1);
+        long next = r.month==12?days_from_civil(year+1, 1, 1):days_from_civil(year, r.month+1, 1);
+        // µһָڼټܣ5ܼһ
+        long w = (first+4)%7;
+        long day = first + (r.weekday - (w<0?w+7:w) + 7)%7 + (long)(r.week-1)*7;
+        while( day >= next ) {
+            day -= 7;
+        }
+        return (long long)day*86400 + r.time;
+    }
+
+    inline bool time_zone::is_dst(std::time_t t) const {
+        if( !has_dst_ ) {
+            return false;
+        }
+        long long local = (long long)t + std_offset_;
+        long days = (long)(local/86400 - (local%86400 < 0));
+        int year, month, day;
+        civil_from_days(days, year, month, day);
+        long long start = transition(year, start_) - std_offset_;
+        long long end = transition(year, end_) - dst_offset_;
+        if( start < end ) {
+            return t >= start && t < end;
+        }
+        // ϰʱ
+        return t < end || t >= start;
+    }
+
+    inline long time_zone::utc_offset(std::time_t t) const {
+        return is_dst(t)?dst_offset_:std_offset_;
+    }
+
+    inline std::time_t time_zone::to_utc(long long local) const {
+        std::time_t t = (std::time_t)(local - std_offset_);
+        if( !has_dst_ || !is_dst(t) ) {
+            return t;
+        }
+        std::time_t d = (std::time_t)(local - dst_offset_);
+        return is_dst(d)?d:t;
+    }
+
+    inline std::time_t time_zone::make_time(int year, int month, int day, int hour, int minu, int sec) const {
+        int m = month-1;
+        year += m/12 - (m%12 < 0);
+        month = (m%12+12)%12 + 1;
+        return to_utc((long long)days_from_civil(year, month, day)*86400
+            + (long long)hour*3600 + (long long)minu*60 + sec);
+    }
+
+    inline void time_zone::fields(std::time_t t, datetime_fields& f) const {
+        civil_fields((long long)t + utc_offset(t), f);
+    }
+
+    inline void time_zone::fields(const std::time_t* t, datetime_fields* f, std::size_t n) const {
+        for( std::size_t i=0; i<n; ++i ) {
+            civil_fields((long long)t[i] + utc_offset(t[i]), f[i]);
+        }
+    }
+
+    inline bool time_zone::parse_name(const char*& p) {
+        if( *p == '<' ) {
+            while( *p != 0 && *p != '>' ) {
+                ++p;
+            }
+            if( *p != '>' ) {
+                return false;
+            }
+            ++p;
+            return true;
+        }
+        const char* begin = p;
+        while( (*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z') ) {
+            ++p;
+        }
+        return p-begin >= 3;
+    }
+
+    inline bool time_zone::parse_time(const char*& p, long& seconds) {
+        // [+|-]hh[:mm[:ss]]
+        long sign = 1;
+        if( *p == '+' || *p == '-' ) {
+            sign = *p=='-'?-1:1;
+            ++p;
+        }
+        long part[3] = { 0, 0, 0 };
+        for( int i=0; i<3; ++i ) {
+            if( *p < '0' || *p > '9' ) {
+                return false;
+            }
+            while( *p >= '0' && *p <= '9' ) {
+                part[i] = part[i]*10 + (*p-'0');
+                ++p;
+            }
+            if( *p != ':' || i == 2 ) {
+                break;
+            }
+            ++p;
+        }
+        seconds = sign*(part[0]*3600 + part[1]*60 + part[2]);
+        return true;
+    }
+
+    inline bool time_zone::parse_rule(const char*& p, tz_rule& r) {
+        // Mm.w.d[/time]
+        if( *p != 'M' ) {
+            return false;
+        }
+        ++p;
+        int v[3] = { 0, 0, 0 };
+        for( int i=0; i<3; ++i ) {
+            if( *p < '0' || *p > '9' ) {
+                return false;
+            }
+            while( *p >= '0' && *p <= '9' ) {
+                v[i] = v[i]*10 + (*p-'0');
+                ++p;
+            }
+            if( i < 2 ) {
+                if( *p != '.' ) {
+                    return false;
+                }
+                ++p;
+            }
+        }
+        if( v[0] < 1 || v[0] > 12 || v[1] < 1 || v[1] > 5 || v[2] > 6 ) {
+            return false;
+        }
+        long time = 7200;
+        if( *p == '/' && !parse_time(++p, time) ) {
+            return false;
+        }
+        r = tz_rule(v[0], v[1], v[2], time);
+        return true;
+    }
+
+    inline bool time_zone::parse(const char* tz) {
+        const char* p = tz;
+        long offset;
+        if( p == 0 || !parse_name(p) || !parse_time(p, offset) ) {
+            return false;
+        }
+        // POSIX TZеƫΪ
+        time_zone result(-offset);
+        if( *p != 0 ) {
+            if( !parse_name(p) ) {
+                return false;
+            }
+            long dst = -offset+3600;
+            if( *p != 0 && *p != ',' ) {
+                if( !parse_time(p, dst) ) {
+                    return false;
+                }
+                dst = -dst;
+            }
+            tz_rule start(3, 2, 0), end(11, 1, 0);
+            if( *p == ',' ) {
+                if( !parse_rule(++p, start) || *p != ',' || !parse_rule(++p, end) ) {
+                    return false;
+                }
+            }
+            if( *p != 0 ) {
+                return false;
+            }
+            result = time_zone(-offset, dst, start, end);
+        }
+        *this = result;
+        return true;
+    }
+
+    inline datetime::offset_cache& datetime::local_cache() {
+        // ʼstateȫΪ0
+        static WUYA_TLS offset_cache c;
+        return c;
+    }
+
+    inline long datetime::system_offset(std::time_t t, bool& dst) {
         struct tm newtime;
 #ifdef _MSC_VER
-        localtime_s(&newtime, &time_);
+        bool ok = localtime_s(&newtime, &t) == 0;
 #else
-        localtime_r(&time_, &newtime);
+        bool ok = localtime_r(&t, &newtime) != 0;
 #endif
-        return newtime.tm_year+1900;
+        dst = false;
+        if( !ok ) {
+            return 0;
+        }
+        dst = newtime.tm_isdst > 0;
+        long long local = (long long)days_from_civil(newtime.tm_year+1900, newtime.tm_mon+1, newtime.tm_mday)*86400
+            + newtime.tm_hour*3600 + newtime.tm_min*60 + newtime.tm_sec;
+        return (long)(local - (long long)t);
+    }
+
+    inline long datetime::local_offset(std::time_t t, bool& dst) {
+        offset_cache& c = local_cache();
+        long long day = (long long)t/86400 - ((long long)t%86400 < 0);
+        int i = (int)(day & (OFFSET_CACHE_SIZE-1));
+        if( c.state[i] != 0 && c.day[i] == day ) {
+            dst = c.state[i] == 2;
+            return c.offset[i];
+        }
+        bool dst_end;
+        long offset = system_offset((std::time_t)(day*86400), dst);
+        if( system_offset((std::time_t)(day*86400+86399), dst_end) != offset || dst_end != dst ) {
+            // л
+            return system_offset(t, dst);
+        }
+        c.day[i] = day;
+        c.offset[i] = offset;
+        c.state[i] = dst?2:1;
+        return offset;
+    }
+
+    inline long datetime::utc_offset(std::time_t t) {
+        bool dst;
+        return local_offset(t, dst);
+    }
+
+    inline datetime_fields datetime::fields() const {
+        datetime_fields f;
+        civil_fields((long long)time_ + utc_offset(time_), f);
+        return f;
+    }
+
+    inline datetime_fields datetime::fields(const time_zone& tz) const {
+        datetime_fields f;
+        tz.fields(time_, f);
+        return f;
+    }
+
+    // õ
+    inline int datetime::year() const {
+        return fields().year;
     }
 
     // õ·
     inline int datetime::month() const {
-        struct tm newtime;
-#ifdef _MSC_VER
-        localtime_s(&newtime, &time_);
-#else
-        localtime_r(&time_, &newtime);
-#endif
-        return newtime.tm_mon+1;
+        return fields().month;
     }
 
     // õ
     inline int datetime::day() const {
-        struct tm newtime;
-#ifdef _MSC_VER
-        localtime_s(&newtime, &time_);
-#else
-        localtime_r(&time_, &newtime);
-#endif
-        return newtime.tm_mday;
+        return fields().day;
     }
 
     // õСʱ
     inline int datetime::hour() const {
-        struct tm newtime;
-#ifdef _MSC_VER
-        localtime_s(&newtime, &time_);
-#else
-        localtime_r(&time_, &newtime);
-#endif
-        return newtime.tm_hour;
+        return fields().hour;
     }
 
     // õ
     inline int datetime::minute() const {
-        struct tm newtime;
-#ifdef _MSC_VER
-        localtime_s(&newtime, &time_);
-#else
-        localtime_r(&time_, &newtime);
-#endif
-        return newtime.tm_min;
+        return fields().minute;
     }
 
     // õ
     inline int datetime::second() const {
-        struct tm newtime;
-#ifdef _MSC_VER
-        localtime_s(&newtime, &time_);
-#else
-        localtime_r(&time_, &newtime);
-#endif
-        return newtime.tm_sec;
+        return fields().second;
     }
 
     // õ 1=Sun, 2=Mon, ..., 7=Sat
     inline int datetime::get_day_of_week() const {
-        struct tm newtime;
-#ifdef _MSC_VER
-        localtime_s(&newtime, &time_);
-#else
-        localtime_r(&time_, &newtime);
-#endif
-        return newtime.tm_wday+1;
+        return fields().day_of_week;
     }
 
     // ж2ʱǷȣtrue,false
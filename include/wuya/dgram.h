@@ -0,0 +1,397 @@
+#ifndef __WUYA_DGRAM_H__
+#define __WUYA_DGRAM_H__
+
+#include <cerrno>
+#include <cstring>
+#include <wuya/socket.h>
+#if defined(__linux__)
+	#include <sys/uio.h>
+#endif
+
+namespace wuya{
+	/**
+	 * һݱdataָpacket_ringԤĻ
+	 */
+	struct packet {
+		char* data;
+		int size;
+		// յݱpacket_sizedataֻǰpacket_sizeֽڣLinuxWindows¿ɼ⣩
+		bool truncated;
+		// հʱΪԴַʱΪĿĵַ
+		ip_addr addr;
+	};
+
+	/**
+	 * ԤݱζУsock_dgramշ
+	 * аĻշϵͳṹڹʱһη䣬շвٷڴ档
+	 * ̰߳ȫÿշ߳ʹøԵpacket_ring
+	 *
+	 * @author wuya
+	 */
+	class packet_ring {
+	public:
+		// countpacket_sizeС1ʱ1
+		explicit packet_ring(int count=64, int packet_size=2048);
+		~packet_ring();
+	public:
+		int capacity() const;
+		int packet_size() const;
+		// еİ
+		int size() const;
+		bool empty() const;
+		bool full() const;
+		void clear();
+		// ȡ׵İ
+		packet& front();
+		// ׵İ
+		void pop();
+		/**
+		 * ݿһаڷ
+		 *
+		 * @return ɹ0ݳ-1
+		 */
+		int push(const void* buf, int n, const ip_addr& to);
+	private:
+		friend class sock_dgram;
+		packet& at(int i);
+		// β𲻻ƵĿа
+		int free_span() const;
+		// 𲻻Ƶð
+		int used_span() const;
+
+		int capacity_;
+		int packet_size_;
+		int head_;
+		int count_;
+		char* buf_;
+		packet* packets_;
+#if defined(__linux__)
+		mmsghdr* hdrs_;
+		iovec* iovs_;
+#endif
+	private:
+		packet_ring(const packet_ring& );
+		packet_ring& operator=(const packet_ring& );
+	};
+
+	/**
+	 * UDPݱ׽
+	 * Linuxrecvmmsg/sendmmsgշһϵͳô
+	 * ߳հʱ߳reuse_portʽͬһ˿ڣں˷SO_REUSEPORT
+	 *
+	 * @author wuya
+	 */
+	class sock_dgram {
+	public:
+		sock_dgram();
+		explicit sock_dgram(const ip_addr& local_sap, int reuse_port=0);
+		/**
+		 * ׽
+		 *
+		 * @param local_sap  صַ
+		 * @param reuse_port Ϊ0ʱSO_REUSEPORT׽ְͬһ˿
+		 * @param buf_size   Ϊ0ʱշС
+		 *
+		 * @return ɹ0ʧܷ-1
+		 */
+		int open(const ip_addr& local_sap, int reuse_port=0, int buf_size=0);
+		// 󶨵׽֣ڷ
+		int open();
+		int close();
+	public:
+		int recv(void* buf, int n, ip_addr& from);
+		int send(const void* buf, int n, const ip_addr& to);
+		/**
+		 * հringĿλãٵȴһ
+		 * ݱض£packet::truncated
+		 *
+		 * @param nonblock Ϊtrueʱȴް0
+		 *
+		 * @return յİʧܷ-1
+		 */
+		int recv_batch(packet_ring& ring, bool nonblock=false);
+		/**
+		 * ringеİѷ͵İringƳ
+		 *
+		 * @return ͵İʧܷ-1
+		 */
+		int send_batch(packet_ring& ring);
+	public:
+		socket_type get_handler();
+		void set_handler(socket_type h);
+	protected:
+		socket_type sock_;
+	private:
+		sock_dgram(const sock_dgram& );
+		sock_dgram& operator=(const sock_dgram& );
+	};
+}
+
+//.............................ʵֲ.............................//
+namespace wuya{
+	inline packet_ring::packet_ring(int count, int packet_size):capacity_(count),
+	packet_size_(packet_size),head_(0),count_(0) {
+		if (count < 1) {
+			count = capacity_ = 1;
+		}
+		if (packet_size < 1) {
+			packet_size = packet_size_ = 1;
+		}
+		buf_ = new char[(size_t)count*packet_size];
+		packets_ = new packet[count];
+#if defined(__linux__)
+		hdrs_ = new mmsghdr[count];
+		iovs_ = new iovec[count];
+		memset(hdrs_, 0, sizeof(mmsghdr)*count);
+#endif
+		for (int i=0; i<count; ++i) {
+			packets_[i].data = buf_+(size_t)i*packet_size;
+			packets_[i].size = 0;
+			packets_[i].truncated = false;
+#if defined(__linux__)
+			iovs_[i].iov_base = packets_[i].data;
+			iovs_[i].iov_len = packet_size;
+			hdrs_[i].msg_hdr.msg_iov = &iovs_[i];
+			hdrs_[i].msg_hdr.msg_iovlen = 1;
+			hdrs_[i].msg_hdr.msg_name = packets_[i].addr.get_addr();
+#endif
+		}
+	}
+
+	inline packet_ring::~packet_ring() {
+#if defined(__linux__)
+		delete [] iovs_;
+		delete [] hdrs_;
+#endif
+		delete [] packets_;
+		delete [] buf_;
+	}
+
+	inline int packet_ring::capacity() const {
+		return capacity_;
+	}
+
+	inline int packet_ring::packet_size() const {
+		return packet_size_;
+	}
+
+	inline int packet_ring::size() const {
+		return count_;
+	}
+
+	inline bool packet_ring::empty() const {
+		return count_ == 0;
+	}
+
+	inline bool packet_ring::full() const {
+		return count_ == capacity_;
+	}
+
+	inline void packet_ring::clear() {
+		head_ = count_ = 0;
+	}
+
+	inline packet& packet_ring::at(int i) {
+		return packets_[i];
+	}
+
+	inline packet& packet_ring::front() {
+		return packets_[head_];
+	}
+
+	inline void packet_ring::pop() {
+		if (count_ == 0) {
+			return;
+		}
+		head_ = (head_+1)%capacity_;
+		--count_;
+	}
+
+	inline int packet_ring::push(const void* buf, int n, const ip_addr& to) {
+		if (full() || n > packet_size_) {
+			return -1;
+		}
+		packet& p = packets_[(head_+count_)%capacity_];
+		memcpy(p.data, buf, n);
+		p.size = n;
+		p.truncated = false;
+		p.addr = to;
+		++count_;
+		return 0;
+	}
+
+	inline int packet_ring::free_span() const {
+		int tail = (head_+count_)%capacity_;
+		int n = capacity_-count_;
+		return tail+n>capacity_?capacity_-tail:n;
+	}
+
+	inline int packet_ring::used_span() const {
+		return head_+count_>capacity_?capacity_-head_:count_;
+	}
+
+	inline sock_dgram::sock_dgram():sock_(INVALID_SOCKET) {
+	}
+
+	inline sock_dgram::sock_dgram(const ip_addr& local_sap, int reuse_port):sock_(INVALID_SOCKET) {
+		open(local_sap, reuse_port);
+	}
+
+	inline int sock_dgram::open() {
+		sock_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+		return sock_ == INVALID_SOCKET?-1:0;
+	}
+
+	inline int sock_dgram::open(const ip_addr& local_sap, int reuse_port, int buf_size) {
+		if (open() != 0) {
+			return -1;
+		}
+		if (reuse_port) {
+			int one = 1;
+#ifdef SO_REUSEPORT
+			setsockopt(sock_, SOL_SOCKET, SO_REUSEPORT, (const char*)&one, sizeof one);
+#else
+			setsockopt(sock_, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof one);
+#endif
+		}
+		if (buf_size > 0) {
+			setsockopt(sock_, SOL_SOCKET, SO_RCVBUF, (const char*)&buf_size, sizeof buf_size);
+			setsockopt(sock_, SOL_SOCKET, SO_SNDBUF, (const char*)&buf_size, sizeof buf_size);
+		}
+		if (bind (sock_, (sockaddr*)local_sap.get_addr(), sizeof(sockaddr_in)) == SOCKET_ERROR) {
+			return -1;
+		}
+		return 0;
+	}
+
+	inline int sock_dgram::close() {
+		if (sock_ == INVALID_SOCKET) {
+			return 0;
+		}
+#if defined(WIN32)||defined(_WIN32)
+		int ret = ::closesocket(sock_);
+#else
+		int ret = ::close(sock_);
+#endif
+		sock_ = INVALID_SOCKET;
+		return ret == SOCKET_ERROR?-1:0;
+	}
+
+	inline int sock_dgram::recv(void* buf, int n, ip_addr& from) {
+#ifdef SOCKLEN_T
+		socklen_t len = sizeof(sockaddr_in);
+#else
+		int len = sizeof(sockaddr_in);
+#endif
+		return ::recvfrom(sock_, (char*)buf, n, 0, (sockaddr*)from.get_addr(), &len);
+	}
+
+	inline int sock_dgram::send(const void* buf, int n, const ip_addr& to) {
+		return ::sendto(sock_, (const char*)buf, n, 0, (sockaddr*)to.get_addr(), sizeof(sockaddr_in));
+	}
+
+	inline int sock_dgram::recv_batch(packet_ring& ring, bool nonblock) {
+		int n = ring.free_span();
+		if (n == 0) {
+			return 0;
+		}
+		int tail = (ring.head_+ring.count_)%ring.capacity_;
+#if defined(__linux__)
+		mmsghdr* hdrs = ring.hdrs_+tail;
+		for (int i=0; i<n; ++i) {
+			hdrs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+			ring.iovs_[tail+i].iov_len = ring.packet_size_;
+		}
+		int r = ::recvmmsg(sock_, hdrs, n, nonblock?MSG_DONTWAIT:MSG_WAITFORONE, 0);
+		if (r < 0) {
+			return(nonblock && (errno==EAGAIN || errno==EWOULDBLOCK))?0:-1;
+		}
+		for (int i=0; i<r; ++i) {
+			packet& p = ring.at(tail+i);
+			p.size = (int)hdrs[i].msg_len;
+			p.truncated = (hdrs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+		}
+#else
+		// ûrecvmmsgʱհһ֮ٵȴ
+		int r = 0;
+		while (r < n) {
+			packet& p = ring.at(tail+r);
+	#ifdef SOCKLEN_T
+			socklen_t len = sizeof(sockaddr_in);
+	#else
+			int len = sizeof(sockaddr_in);
+	#endif
+			int flags = 0;
+	#ifdef MSG_DONTWAIT
+			flags = (r>0 || nonblock)?MSG_DONTWAIT:0;
+	#endif
+			int size = ::recvfrom(sock_, p.data, ring.packet_size_, flags, (sockaddr*)p.addr.get_addr(), &len);
+			p.truncated = false;
+	#if defined(WIN32)||defined(_WIN32)
+			// ݱѰСض£ʧ
+			if (size == SOCKET_ERROR && WSAGetLastError() == WSAEMSGSIZE) {
+				size = ring.packet_size_;
+				p.truncated = true;
+			}
+	#endif
+			if (size < 0) {
+				break;
+			}
+			p.size = size;
+			++r;
+	#ifndef MSG_DONTWAIT
+			break;
+	#endif
+		}
+		if (r == 0 && !nonblock) {
+			return -1;
+		}
+#endif
+		ring.count_ += r;
+		return r;
+	}
+
+	inline int sock_dgram::send_batch(packet_ring& ring) {
+		int total = 0;
+		while (!ring.empty()) {
+			int n = ring.used_span();
+			int head = ring.head_;
+#if defined(__linux__)
+			mmsghdr* hdrs = ring.hdrs_+head;
+			for (int i=0; i<n; ++i) {
+				hdrs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+				ring.iovs_[head+i].iov_len = ring.at(head+i).size;
+			}
+			int r = ::sendmmsg(sock_, hdrs, n, 0);
+			if (r <= 0) {
+				return total>0?total:-1;
+			}
+#else
+			int r = 0;
+			for (; r<n; ++r) {
+				packet& p = ring.at(head+r);
+				if (send(p.data, p.size, p.addr) < 0) {
+					break;
+				}
+			}
+			if (r == 0) {
+				return total>0?total:-1;
+			}
+#endif
+			ring.head_ = (head+r)%ring.capacity_;
+			ring.count_ -= r;
+			total += r;
+		}
+		return total;
+	}
+
+	inline socket_type sock_dgram::get_handler() {
+		return sock_;
+	}
+
+	inline void sock_dgram::set_handler(socket_type h) {
+		sock_ = h;
+	}
+}
+
+#endif
@@ -13,6 +13,7 @@
 #include <ace/OS_NS_sys_time.h>
 #include <ace/OS_NS_unistd.h>
 #include <ace/SOCK_Acceptor.h>
+#include <wuya/trace.h>
 
 namespace wuya {
 	class notification;
@@ -492,6 +493,7 @@ namespace wuya {
 		return false;
 	}
 	inline bool ftp_client::get_response(ftp_reply& reply) const {
+		WUYA_TRACE_SCOPE_CAT("ftp", "response");
 		std::string res;
 		if( !get_single_response_line(res) )
 			return false;
@@ -840,6 +842,7 @@ namespace wuya {
 	}
 	inline bool ftp_client::open_active_data_connection(ACE_SOCK_Stream& stream, DATA_CHANNEL_CMD cmd, 
 														const std::string& path, int offset) const {
+		WUYA_TRACE_SCOPE_CAT("ftp", "data_connect");
 		ACE_SOCK_Acceptor acceptor;
 		ACE_INET_Addr addr((unsigned short int)0, (ACE_UINT32)INADDR_ANY);
 		if( acceptor.open(addr) == -1 ) {
@@ -876,6 +879,7 @@ namespace wuya {
 	}
 	inline bool ftp_client::open_passive_data_connection(ACE_SOCK_Stream& stream, DATA_CHANNEL_CMD cmd,
 														 const std::string& path, int offset) const {
+		WUYA_TRACE_SCOPE_CAT("ftp", "data_connect");
 		ACE_INET_Addr addr;
 
 		// set passive mode
@@ -919,6 +923,7 @@ namespace wuya {
 		return "";
 	}
 	inline bool ftp_client::send_data(trans_notification* observer, ACE_SOCK_Stream& stream) const {
+		WUYA_TRACE_SCOPE_CAT("ftp", "send_data");
 		trans_now_=true;
 		size_t bytes_readed=0;
 		observer->on_pre_bytes_send(buffer_, sizeof(buffer_), bytes_readed);
@@ -945,6 +950,7 @@ namespace wuya {
 	}
 
 	inline bool ftp_client::receive_data(trans_notification* observer, ACE_SOCK_Stream& stream) const {
+		WUYA_TRACE_SCOPE_CAT("ftp", "receive_data");
 		trans_now_ = true;
 
 		for( observer_set::const_iterator it=observers_.begin(); it!=observers_.end(); ++it )
@@ -1029,6 +1035,7 @@ namespace wuya {
 	inline bool ftp_client::execute_data_command(DATA_CHANNEL_CMD cmd, const std::string& path, 
 												 TRANS_TYPE type, FORMAT_TYPE observers_, bool is_pasv,
 												 long offset, trans_notification* observer) const {
+		WUYA_TRACE_SCOPE_CAT("ftp", "transfer");
 		if( trans_now_ || !is_connected() )
 			return false;
 
@@ -0,0 +1,388 @@
+#ifndef __WUYA_HISTOGRAM_H__
+#define __WUYA_HISTOGRAM_H__
+
+#include <wuya/atomic.h>
+#include <wuya/timer.h>
+
+namespace wuya{
+	template<int Bits_>
+	class concurrent_histogram;
+
+	/**
+	 * -ԷͰֱͼHDR񣩣ڴ̶¼Ϊʱ
+	 * С2^Bits_ֵÿֵһͰֵ2ݷֶΣÿԷΪ2^(Bits_-1)Ͱ
+	 * 2^(1-Bits_)ȱʡ7λ1/64Լ1.6%
+	 * ֵΪ[0, 2^63)0¼ڴΪ(65-Bits_)*2^(Bits_-1)7λʱԼ29KB
+	 *
+	 * ֻһ̼߳¼ⲿ֤ͬһʱֻһ߳ͬʱȡ
+	 * ߳ͬʱ¼ʱʹconcurrent_histogram
+	 *
+	 * ʹ÷
+	 *   wuya::histogram<> h;
+	 *   wuya::mono_timer t(true);
+	 *   ...
+	 *   h.record(t.elapsed_ns());
+	 *   printf("p50=%lld p99=%lld p999=%lld max=%lld\n", h.percentile(50), h.percentile(99),
+	 *          h.percentile(99.9), h.max());
+	 *
+	 * @author wuya
+	 */
+	template<int Bits_=7>
+	class histogram {
+	public:
+		enum {
+			BITS = Bits_,
+			// ȷ¼ֵĸ
+			SUB_BUCKETS = 1<<Bits_,
+			HALF_BUCKETS = SUB_BUCKETS/2,
+			BUCKETS = (65-Bits_)*HALF_BUCKETS
+		};
+		histogram();
+		// ΪգԴͬʱ¼
+		histogram(const histogram& src);
+		histogram& operator=(const histogram& src);
+	public:
+		void record(long long v);
+		// ¼nͬһֵ
+		void record(long long v, long long n);
+		void reset();
+		// һֱͼļ¼ڻ̻ܶ߳ʱ
+		void merge(const histogram& src);
+		long long count() const;
+		long long sum() const;
+		// ûм¼ʱmin()max()Ϊ0
+		long long min() const;
+		long long max() const;
+		double mean() const;
+		/**
+		 * pٷλֵСڸñļ¼ͰϽ磬max()
+		 *
+		 * @param p      0~100509999.9
+		 */
+		long long percentile(double p) const;
+		// Ͱiļ¼
+		long long bucket(int i) const;
+		// ֵvڵͰ
+		static int index(long long v);
+		// Ͱiֵ[lowest(i), highest(i)]
+		static long long lowest(int i);
+		static long long highest(int i);
+	private:
+		friend class concurrent_histogram<Bits_>;
+		void copy(const histogram& src);
+		void add(long long v, long long n);
+
+		volatile long long buckets_[BUCKETS];
+		volatile long long count_;
+		volatile long long sum_;
+		volatile long long min_;
+		volatile long long max_;
+	};
+
+	/**
+	 * ɶ߳ͬʱ¼ֱͼ¼
+	 * ֻ߳ڵͰԭӼӣڶȡʱͣȡǰsnapshot()ȡhistogramա
+	 *
+	 * @author wuya
+	 */
+	template<int Bits_=7>
+	class concurrent_histogram {
+	public:
+		typedef histogram<Bits_> snapshot_type;
+		enum { BUCKETS = snapshot_type::BUCKETS };
+		concurrent_histogram();
+	public:
+		void record(long long v);
+		// ȡÿգ¼ͬʱУеֵ֮г
+		void snapshot(snapshot_type& h) const;
+		// 㣬¼ͬʱʱ©¼
+		void reset();
+		long long count() const;
+		long long max() const;
+	private:
+		volatile long long buckets_[BUCKETS];
+		volatile long long sum_;
+		volatile long long min_;
+		volatile long long max_;
+	private:
+		concurrent_histogram(const concurrent_histogram& );
+		concurrent_histogram& operator=(const concurrent_histogram& );
+	};
+
+	/**
+	 * ʱʱ¼ֱͼ
+	 * Timer_Ϊmono_timercycle_timerthread_cpu_timer
+	 *
+	 *   {
+	 *       wuya::scoped_latency<wuya::concurrent_histogram<> > lat(h);
+	 *       ...
+	 *   }
+	 */
+	template<class Histogram_, class Timer_=mono_timer>
+	class scoped_latency {
+	public:
+		explicit scoped_latency(Histogram_& h):h_(h),timer_(true) {
+		}
+		~scoped_latency() {
+			h_.record(static_cast<long long>(timer_.elapsed_ns()));
+		}
+	private:
+		Histogram_& h_;
+		Timer_ timer_;
+	private:
+		scoped_latency(const scoped_latency& );
+		scoped_latency& operator=(const scoped_latency& );
+	};
+}
+
+//.............................ʵֲ.............................//
+namespace wuya{
+	template<int Bits_>
+	inline histogram<Bits_>::histogram() {
+		reset();
+	}
+
+	template<int Bits_>
+	inline histogram<Bits_>::histogram(const histogram& src) {
+		copy(src);
+	}
+
+	template<int Bits_>
+	inline histogram<Bits_>& histogram<Bits_>::operator=(const histogram& src) {
+		if (this != &src) {
+			copy(src);
+		}
+		return *this;
+	}
+
+	template<int Bits_>
+	inline void histogram<Bits_>::copy(const histogram& src) {
+		for (int i=0; i<BUCKETS; ++i) {
+			buckets_[i] = atomic_load(&src.buckets_[i]);
+		}
+		count_ = atomic_load(&src.count_);
+		sum_ = atomic_load(&src.sum_);
+		min_ = atomic_load(&src.min_);
+		max_ = atomic_load(&src.max_);
+	}
+
+	template<int Bits_>
+	inline void histogram<Bits_>::reset() {
+		for (int i=0; i<BUCKETS; ++i) {
+			atomic_store(&buckets_[i], 0LL);
+		}
+		atomic_store(&count_, 0LL);
+		atomic_store(&sum_, 0LL);
+		atomic_store(&min_, 0LL);
+		atomic_store(&max_, 0LL);
+	}
+
+	template<int Bits_>
+	inline int histogram<Bits_>::index(long long v) {
+		if (v < SUB_BUCKETS) {
+			return v<0?0:(int)v;
+		}
+#if defined(__GNUC__)
+		int msb = 63-__builtin_clzll((unsigned long long)v);
+#else
+		int msb = 0;
+		for (unsigned long long u=(unsigned long long)v>>1; u!=0; u>>=1) {
+			++msb;
+		}
+#endif
+		int shift = msb-Bits_+1;
+		return shift*HALF_BUCKETS+(int)(v>>shift);
+	}
+
+	template<int Bits_>
+	inline long long histogram<Bits_>::lowest(int i) {
+		if (i < SUB_BUCKETS) {
+			return i;
+		}
+		int shift = i/HALF_BUCKETS-1;
+		return (long long)(i-shift*HALF_BUCKETS)<<shift;
+	}
+
+	template<int Bits_>
+	inline long long histogram<Bits_>::highest(int i) {
+		if (i < SUB_BUCKETS) {
+			return i;
+		}
+		int shift = i/HALF_BUCKETS-1;
+		return lowest(i)+(((long long)1<<shift)-1);
+	}
+
+	template<int Bits_>
+	inline void histogram<Bits_>::add(long long v, long long n) {
+		// ߳д룬atomic_storeֵֻ֤߲
+		int i = index(v);
+		atomic_store(&buckets_[i], buckets_[i]+n);
+		atomic_store(&sum_, sum_+v*n);
+		if (count_ == 0 || v < min_) {
+			atomic_store(&min_, v);
+		}
+		if (v > max_) {
+			atomic_store(&max_, v);
+		}
+		atomic_store(&count_, count_+n);
+	}
+
+	template<int Bits_>
+	inline void histogram<Bits_>::record(long long v) {
+		add(v<0?0:v, 1);
+	}
+
+	template<int Bits_>
+	inline void histogram<Bits_>::record(long long v, long long n) {
+		if (n > 0) {
+			add(v<0?0:v, n);
+		}
+	}
+
+	template<int Bits_>
+	inline void histogram<Bits_>::merge(const histogram& src) {
+		histogram s(src);
+		if (s.count_ == 0) {
+			return;
+		}
+		for (int i=0; i<BUCKETS; ++i) {
+			if (s.buckets_[i] != 0) {
+				atomic_store(&buckets_[i], buckets_[i]+s.buckets_[i]);
+			}
+		}
+		atomic_store(&sum_, sum_+s.sum_);
+		if (count_ == 0 || s.min_ < min_) {
+			atomic_store(&min_, s.min_);
+		}
+		if (s.max_ > max_) {
+			atomic_store(&max_, s.max_);
+		}
+		atomic_store(&count_, count_+s.count_);
+	}
+
+	template<int Bits_>
+	inline long long histogram<Bits_>::count() const {
+		return atomic_load(&count_);
+	}
+
+	template<int Bits_>
+	inline long long histogram<Bits_>::sum() const {
+		return atomic_load(&sum_);
+	}
+
+	template<int Bits_>
+	inline long long histogram<Bits_>::min() const {
+		return atomic_load(&min_);
+	}
+
+	template<int Bits_>
+	inline long long histogram<Bits_>::max() const {
+		return atomic_load(&max_);
+	}
+
+	template<int Bits_>
+	inline double histogram<Bits_>::mean() const {
+		long long n = count();
+		return n==0?0:(double)sum()/n;
+	}
+
+	template<int Bits_>
+	inline long long histogram<Bits_>::bucket(int i) const {
+		return atomic_load(&buckets_[i]);
+	}
+
+	template<int Bits_>
+	inline long long histogram<Bits_>::percentile(double p) const {
+		// ԸͰ֮Ϊ׼¼ͬʱȡʱҲԽ
+		long long total = 0;
+		for (int i=0; i<BUCKETS; ++i) {
+			total += bucket(i);
+		}
+		if (total == 0) {
+			return 0;
+		}
+		long long rank = (long long)(total*p/100+0.5);
+		if (rank < 1) {
+			rank = 1;
+		}
+		long long n = 0;
+		long long top = max();
+		for (int i=0; i<BUCKETS; ++i) {
+			n += bucket(i);
+			if (n >= rank) {
+				long long upper = highest(i);
+				return upper<top?upper:top;
+			}
+		}
+		return top;
+	}
+
+	template<int Bits_>
+	inline concurrent_histogram<Bits_>::concurrent_histogram() {
+		reset();
+	}
+
+	template<int Bits_>
+	inline void concurrent_histogram<Bits_>::reset() {
+		for (int i=0; i<BUCKETS; ++i) {
+			atomic_store(&buckets_[i], 0LL);
+		}
+		atomic_store(&sum_, 0LL);
+		atomic_store(&min_, -1LL);
+		atomic_store(&max_, 0LL);
+	}
+
+	template<int Bits_>
+	inline void concurrent_histogram<Bits_>::record(long long v) {
+		if (v < 0) {
+			v = 0;
+		}
+		atomic_add(&buckets_[snapshot_type::index(v)], 1LL);
+		atomic_add(&sum_, v);
+		// ֵܿȶֻͨһζ
+		long long m = atomic_load(&max_);
+		while (v > m && !atomic_cas(&max_, m, v)) {
+			m = atomic_load(&max_);
+		}
+		m = atomic_load(&min_);
+		while ((m < 0 || v < m) && !atomic_cas(&min_, m, v)) {
+			m = atomic_load(&min_);
+		}
+	}
+
+	template<int Bits_>
+	inline void concurrent_histogram<Bits_>::snapshot(snapshot_type& h) const {
+		h.reset();
+		long long sum = atomic_load(&sum_);
+		long long lo = atomic_load(&min_);
+		long long hi = atomic_load(&max_);
+		for (int i=0; i<BUCKETS; ++i) {
+			long long n = atomic_load(&buckets_[i]);
+			if (n != 0) {
+				// Ͱ½룬ʵʵĺֵ
+				h.record(snapshot_type::lowest(i), n);
+			}
+		}
+		if (h.count_ != 0) {
+			h.sum_ = sum;
+			h.min_ = lo<0?0:lo;
+			h.max_ = hi;
+		}
+	}
+
+	template<int Bits_>
+	inline long long concurrent_histogram<Bits_>::count() const {
+		long long n = 0;
+		for (int i=0; i<BUCKETS; ++i) {
+			n += atomic_load(&buckets_[i]);
+		}
+		return n;
+	}
+
+	template<int Bits_>
+	inline long long concurrent_histogram<Bits_>::max() const {
+		return atomic_load(&max_);
+	}
+}
+
+#endif
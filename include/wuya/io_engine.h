@@ -0,0 +1,707 @@
+#ifndef __WUYA_IO_ENGINE_H__
+#define __WUYA_IO_ENGINE_H__
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#if defined(__linux__) && !defined(WUYA_NO_IO_URING)
+	#define WUYA_HAS_IO_URING
+	#include <unistd.h>
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/uio.h>
+	#include <sys/syscall.h>
+	#include <linux/io_uring.h>
+#elif !defined(WIN32)&&!defined(_WIN32)
+	#include <unistd.h>
+	#include <fcntl.h>
+	#include <sys/uio.h>
+#endif
+#include <wuya/socket.h>
+
+namespace wuya{
+#if defined(WIN32)||defined(_WIN32)
+	struct iovec {
+		void* iov_base;
+		size_t iov_len;
+	};
+#endif
+	/**
+	 * һ¼
+	 */
+	struct io_completion {
+		// ύʱû
+		unsigned long long user_data;
+		// ͬӦϵͳõķֵʱΪerrno
+		int res;
+	};
+
+	/**
+	 * 첽I/O棬Linux»io_uringʵ
+	 * ֧acceptrecvsendreadwritesplice֧עỺļ
+	 * һύһϵͳüɴ
+	 *
+	 * io_uringãLinuxں˲ֻ֧WUYA_NO_IO_URINGʱ
+	 * submit()ύ˳ʽִУӿڱֲ䡣
+	 * ں֧io_uringָ֧ʱ5.7ǰûspliceʱѯ֪
+	 * Щͬsubmit()ʱʽִУio_uringеĲ֮䲻֤˳IO_LINKЧ
+	 *
+	 * ÷
+	 *   io_engine io(256);
+	 *   io.recv(fd, buf, sizeof buf, 1);
+	 *   io.submit();
+	 *   io_completion c[16];
+	 *   int n = io.wait(c, 16);
+	 *
+	 * @author wuya
+	 */
+	class io_engine {
+	public:
+		enum {
+			DEFAULT_ENTRIES = 256
+		};
+		// ־ɰλ
+		enum op_flag {
+			// fdΪregister_files()עʱ±
+			FIXED_FILE = 0x1,
+			// ɺſʼһ
+			IO_LINK = 0x2
+		};
+		explicit io_engine(unsigned entries = DEFAULT_ENTRIES);
+		~io_engine();
+	public:
+		// Ƿʹio_uringΪʽں˲ֵ֧ĲʽִУ
+		bool available() const;
+		/**
+		 * ·ύУsubmit()ύ
+		 *
+		 * @return ɹ0ύ-1ʱӦsubmit
+		 */
+		int accept(socket_type fd, sockaddr* addr, socklen_t* len,
+				   unsigned long long user_data, unsigned flags = 0);
+		int recv(socket_type fd, void* buf, unsigned len, unsigned long long user_data,
+				 int msg_flags = 0, unsigned flags = 0);
+		int send(socket_type fd, const void* buf, unsigned len, unsigned long long user_data,
+				 int msg_flags = 0, unsigned flags = 0);
+		// offsetΪ-1ʱʹõǰļλ
+		int read(int fd, void* buf, unsigned len, long long offset,
+				 unsigned long long user_data, unsigned flags = 0);
+		int write(int fd, const void* buf, unsigned len, long long offset,
+				  unsigned long long user_data, unsigned flags = 0);
+		// bufλregister_buffers()עĵbuf_index֮
+		int read_fixed(int fd, void* buf, unsigned len, long long offset, int buf_index,
+					   unsigned long long user_data, unsigned flags = 0);
+		int write_fixed(int fd, const void* buf, unsigned len, long long offset, int buf_index,
+						unsigned long long user_data, unsigned flags = 0);
+		// fd_infd_outһΪܵܵһ˵offsetΪ-1
+		int splice(int fd_in, long long off_in, int fd_out, long long off_out, unsigned len,
+				   unsigned long long user_data, unsigned flags = 0);
+		/**
+		 * ע̶ںԤӳ䣬ÿβҳ
+		 *
+		 * @return ɹ0ʧܷ-1
+		 */
+		int register_buffers(const iovec* iovs, unsigned n);
+		int unregister_buffers();
+		/**
+		 * עļ֮FIXED_FILE־ʹ±fd
+		 *
+		 * @return ɹ0ʧܷ-1
+		 */
+		int register_files(const int* fds, unsigned n);
+		int unregister_files();
+		/**
+		 * ύŶӵĲ
+		 * ںһδȡʱύɶʱȽ¼ȡڲԣ
+		 * δύύУqueued()´submit()ʱһύ
+		 *
+		 * @param wait_nr ͬʱȴwait_nr
+		 *
+		 * @return ύĲһҲδύʱ-1
+		 */
+		int submit(unsigned wait_nr = 0);
+		/**
+		 * ȡɵ¼
+		 *
+		 * @return ȡõ¼
+		 */
+		int peek(io_completion* cqes, int max);
+		/**
+		 * ȡɵ¼ٵȴmin_nr
+		 *
+		 * @return ȡõ¼ʧܷ-1
+		 */
+		int wait(io_completion* cqes, int max, unsigned min_nr = 1);
+		// ŶδύںδȡߣĲ
+		unsigned queued() const;
+	private:
+		enum op_type {
+			OP_ACCEPT, OP_RECV, OP_SEND, OP_READ, OP_WRITE, OP_SPLICE
+		};
+		struct op {
+			op_type type;
+			int fd;
+			int fd2;
+			void* buf;
+			unsigned len;
+			long long off;
+			long long off2;
+			int msg_flags;
+			socklen_t* addrlen;
+			unsigned long long user_data;
+		};
+		int prep(op_type type, int fd, void* buf, unsigned len, long long off,
+				 unsigned long long user_data, unsigned flags, int buf_index = -1);
+		// òǷio_uringִ
+		bool use_ring(op_type type, int buf_index = -1) const;
+		int real_fd(int fd, unsigned flags) const;
+		int run_pending();
+		void run_blocking(const op& o);
+#ifdef WUYA_HAS_IO_URING
+		bool setup(unsigned entries);
+		void probe();
+		void teardown();
+		static int opcode(op_type type, int buf_index);
+		io_uring_sqe* get_sqe();
+		int enter(unsigned to_submit, unsigned min_complete, unsigned flags);
+		int reap();
+
+		int ring_fd_;
+		unsigned sq_entries_;
+		unsigned* sq_head_;
+		unsigned* sq_tail_;
+		unsigned* sq_mask_;
+		unsigned* sq_array_;
+		io_uring_sqe* sqes_;
+		unsigned* cq_head_;
+		unsigned* cq_tail_;
+		unsigned* cq_mask_;
+		io_uring_cqe* cqes_;
+		void* sq_ring_;
+		size_t sq_ring_size_;
+		void* cq_ring_;
+		size_t cq_ring_size_;
+		size_t sqes_size_;
+		unsigned sqe_tail_;
+		unsigned sqe_head_;
+		// ںֵ֧ĲopcodeΪ±
+		bool ops_[IORING_OP_LAST];
+#endif
+		// ʽµĴִвԼδȡߵ¼
+		std::vector<op> pending_;
+		std::deque<io_completion> done_;
+		std::vector<int> files_;
+		unsigned entries_;
+	private:
+		io_engine(const io_engine& );
+		io_engine& operator=(const io_engine& );
+	};
+}
+
+//.............................ʵֲ.............................//
+namespace wuya{
+	inline io_engine::io_engine(unsigned entries):entries_(entries) {
+#ifdef WUYA_HAS_IO_URING
+		ring_fd_ = -1;
+		sq_ring_ = cq_ring_ = 0;
+		sqes_ = 0;
+		sqe_tail_ = sqe_head_ = 0;
+		if (!setup(entries)) {
+			teardown();
+		}
+#endif
+	}
+
+	inline io_engine::~io_engine() {
+#ifdef WUYA_HAS_IO_URING
+		teardown();
+#endif
+	}
+
+	inline bool io_engine::available() const {
+#ifdef WUYA_HAS_IO_URING
+		return ring_fd_ >= 0;
+#else
+		return false;
+#endif
+	}
+
+	inline unsigned io_engine::queued() const {
+		unsigned n = (unsigned)pending_.size();
+#ifdef WUYA_HAS_IO_URING
+		if (available()) {
+			n += sqe_tail_-sqe_head_;
+			n += *sq_tail_-__atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+		}
+#endif
+		return n;
+	}
+
+	inline bool io_engine::use_ring(op_type type, int buf_index) const {
+#ifdef WUYA_HAS_IO_URING
+		if (available()) {
+			return ops_[opcode(type, buf_index)];
+		}
+#endif
+		return false;
+	}
+
+	// FIXED_FILEʱʽ뽫ע±껻ʵʵ
+	inline int io_engine::real_fd(int fd, unsigned flags) const {
+		if ((flags & FIXED_FILE) && fd>=0 && fd<(int)files_.size()) {
+			return files_[fd];
+		}
+		return fd;
+	}
+
+	inline int io_engine::accept(socket_type fd, sockaddr* addr, socklen_t* len,
+								 unsigned long long user_data, unsigned flags) {
+		if (prep(OP_ACCEPT, (int)fd, addr, 0, 0, user_data, flags) != 0) {
+			return -1;
+		}
+#ifdef WUYA_HAS_IO_URING
+		if (use_ring(OP_ACCEPT)) {
+			io_uring_sqe* sqe = &sqes_[(sqe_tail_-1) & *sq_mask_];
+			sqe->addr2 = (unsigned long long)len;
+			return 0;
+		}
+#endif
+		pending_.back().addrlen = len;
+		return 0;
+	}
+
+	inline int io_engine::recv(socket_type fd, void* buf, unsigned len,
+							   unsigned long long user_data, int msg_flags, unsigned flags) {
+		if (prep(OP_RECV, (int)fd, buf, len, 0, user_data, flags) != 0) {
+			return -1;
+		}
+#ifdef WUYA_HAS_IO_URING
+		if (use_ring(OP_RECV)) {
+			sqes_[(sqe_tail_-1) & *sq_mask_].msg_flags = msg_flags;
+			return 0;
+		}
+#endif
+		pending_.back().msg_flags = msg_flags;
+		return 0;
+	}
+
+	inline int io_engine::send(socket_type fd, const void* buf, unsigned len,
+							   unsigned long long user_data, int msg_flags, unsigned flags) {
+		if (prep(OP_SEND, (int)fd, const_cast<void*>(buf), len, 0, user_data, flags) != 0) {
+			return -1;
+		}
+#ifdef WUYA_HAS_IO_URING
+		if (use_ring(OP_SEND)) {
+			sqes_[(sqe_tail_-1) & *sq_mask_].msg_flags = msg_flags;
+			return 0;
+		}
+#endif
+		pending_.back().msg_flags = msg_flags;
+		return 0;
+	}
+
+	inline int io_engine::read(int fd, void* buf, unsigned len, long long offset,
+							   unsigned long long user_data, unsigned flags) {
+		return prep(OP_READ, fd, buf, len, offset, user_data, flags);
+	}
+
+	inline int io_engine::write(int fd, const void* buf, unsigned len, long long offset,
+								unsigned long long user_data, unsigned flags) {
+		return prep(OP_WRITE, fd, const_cast<void*>(buf), len, offset, user_data, flags);
+	}
+
+	inline int io_engine::read_fixed(int fd, void* buf, unsigned len, long long offset, int buf_index,
+									 unsigned long long user_data, unsigned flags) {
+		return prep(OP_READ, fd, buf, len, offset, user_data, flags, buf_index);
+	}
+
+	inline int io_engine::write_fixed(int fd, const void* buf, unsigned len, long long offset, int buf_index,
+									  unsigned long long user_data, unsigned flags) {
+		return prep(OP_WRITE, fd, const_cast<void*>(buf), len, offset, user_data, flags, buf_index);
+	}
+
+	inline int io_engine::splice(int fd_in, long long off_in, int fd_out, long long off_out, unsigned len,
+								 unsigned long long user_data, unsigned flags) {
+		if (prep(OP_SPLICE, fd_out, 0, len, off_out, user_data, flags) != 0) {
+			return -1;
+		}
+#ifdef WUYA_HAS_IO_URING
+		if (use_ring(OP_SPLICE)) {
+			io_uring_sqe* sqe = &sqes_[(sqe_tail_-1) & *sq_mask_];
+			sqe->splice_fd_in = fd_in;
+			sqe->splice_off_in = (unsigned long long)off_in;
+			if (flags & FIXED_FILE) {
+				sqe->splice_flags = SPLICE_F_FD_IN_FIXED;
+			}
+			return 0;
+		}
+#endif
+		pending_.back().fd2 = real_fd(fd_in, flags);
+		pending_.back().off2 = off_in;
+		return 0;
+	}
+
+	inline int io_engine::prep(op_type type, int fd, void* buf, unsigned len, long long off,
+							   unsigned long long user_data, unsigned flags, int buf_index) {
+#ifdef WUYA_HAS_IO_URING
+		if (use_ring(type, buf_index)) {
+			io_uring_sqe* sqe = get_sqe();
+			if (sqe == 0) {
+				return -1;
+			}
+			memset(sqe, 0, sizeof(*sqe));
+			sqe->opcode = (unsigned char)opcode(type, buf_index);
+			sqe->fd = fd;
+			sqe->addr = (unsigned long long)buf;
+			sqe->len = len;
+			sqe->off = (unsigned long long)off;
+			sqe->user_data = user_data;
+			if (buf_index >= 0) {
+				sqe->buf_index = (unsigned short)buf_index;
+			}
+			if (flags & FIXED_FILE) {
+				sqe->flags |= IOSQE_FIXED_FILE;
+			}
+			if (flags & IO_LINK) {
+				sqe->flags |= IOSQE_IO_LINK;
+			}
+			return 0;
+		}
+#endif
+		if (pending_.size() >= entries_) {
+			return -1;
+		}
+		op o;
+		memset(&o, 0, sizeof o);
+		o.type = type;
+		o.fd = real_fd(fd, flags);
+		o.fd2 = -1;
+		o.buf = buf;
+		o.len = len;
+		o.off = off;
+		o.off2 = -1;
+		o.user_data = user_data;
+		pending_.push_back(o);
+		return 0;
+	}
+
+	inline int io_engine::register_buffers(const iovec* iovs, unsigned n) {
+#ifdef WUYA_HAS_IO_URING
+		if (available()) {
+			return syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, iovs, n)<0?-1:0;
+		}
+#endif
+		// ʽֱͨʹ
+		return 0;
+	}
+
+	inline int io_engine::unregister_buffers() {
+#ifdef WUYA_HAS_IO_URING
+		if (available()) {
+			return syscall(__NR_io_uring_register, ring_fd_, IORING_UNREGISTER_BUFFERS, 0, 0)<0?-1:0;
+		}
+#endif
+		return 0;
+	}
+
+	inline int io_engine::register_files(const int* fds, unsigned n) {
+		files_.assign(fds, fds+n);
+#ifdef WUYA_HAS_IO_URING
+		if (available()) {
+			return syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_FILES, fds, n)<0?-1:0;
+		}
+#endif
+		return 0;
+	}
+
+	inline int io_engine::unregister_files() {
+		files_.clear();
+#ifdef WUYA_HAS_IO_URING
+		if (available()) {
+			return syscall(__NR_io_uring_register, ring_fd_, IORING_UNREGISTER_FILES, 0, 0)<0?-1:0;
+		}
+#endif
+		return 0;
+	}
+
+	inline int io_engine::submit(unsigned wait_nr) {
+		int n = run_pending();
+#ifdef WUYA_HAS_IO_URING
+		if (available()) {
+			unsigned tail = *sq_tail_;
+			unsigned mask = *sq_mask_;
+			while (sqe_head_ != sqe_tail_) {
+				sq_array_[tail & mask] = sqe_head_ & mask;
+				++tail;
+				++sqe_head_;
+			}
+			__atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+			// ڲ¼Ҳȴĸ
+			unsigned min_complete = wait_nr>done_.size()?wait_nr-(unsigned)done_.size():0;
+			for (;;) {
+				// ǰδںȡߵ
+				unsigned to_submit = tail-__atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+				if (to_submit == 0 && min_complete == 0) {
+					break;
+				}
+				int r = enter(to_submit, min_complete, min_complete>0?IORING_ENTER_GETEVENTS:0);
+				if (r < 0) {
+					// ɶEBUSYԴȱEAGAINʱȡ¼
+					if ((errno == EBUSY || errno == EAGAIN) && reap() > 0) {
+						continue;
+					}
+					return n>0?n:-1;
+				}
+				n += r;
+				// ںֻȫȡߺŵȴɣδȡʱύ
+				if ((unsigned)r >= to_submit || r == 0) {
+					break;
+				}
+			}
+		}
+#endif
+		return n;
+	}
+
+	// ʽִio_uringûֵ֧Ĳ
+	inline int io_engine::run_pending() {
+		int n = (int)pending_.size();
+		for (std::vector<op>::const_iterator it=pending_.begin(); it!=pending_.end(); ++it) {
+			run_blocking(*it);
+		}
+		pending_.clear();
+		return n;
+	}
+
+	inline int io_engine::peek(io_completion* cqes, int max) {
+		int n = 0;
+		while (!done_.empty() && n < max) {
+			cqes[n++] = done_.front();
+			done_.pop_front();
+		}
+#ifdef WUYA_HAS_IO_URING
+		if (available()) {
+			unsigned head = *cq_head_;
+			unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+			while (head != tail && n < max) {
+				io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+				cqes[n].user_data = cqe.user_data;
+				cqes[n].res = cqe.res;
+				++head;
+				++n;
+			}
+			__atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+		}
+#endif
+		return n;
+	}
+
+	inline int io_engine::wait(io_completion* cqes, int max, unsigned min_nr) {
+		int n = peek(cqes, max);
+		if (n < (int)min_nr && n < max && !pending_.empty()) {
+			run_pending();
+			n += peek(cqes+n, max-n);
+		}
+#ifdef WUYA_HAS_IO_URING
+		if (available()) {
+			while (n < (int)min_nr && n < max) {
+				if (enter(0, min_nr-n, IORING_ENTER_GETEVENTS) < 0) {
+					return n>0?n:-1;
+				}
+				n += peek(cqes+n, max-n);
+			}
+		}
+#endif
+		return n;
+	}
+
+	inline void io_engine::run_blocking(const op& o) {
+		io_completion c;
+		c.user_data = o.user_data;
+		long r = -1;
+		switch (o.type) {
+		case OP_ACCEPT:
+			r = (long)::accept((socket_type)o.fd, (sockaddr*)o.buf, o.addrlen);
+			break;
+		case OP_RECV:
+			r = ::recv((socket_type)o.fd, (char*)o.buf, o.len, o.msg_flags);
+			break;
+		case OP_SEND:
+			r = ::send((socket_type)o.fd, (const char*)o.buf, o.len, o.msg_flags);
+			break;
+#if defined(WIN32)||defined(_WIN32)
+		default:
+			errno = ENOSYS;
+			break;
+#else
+		case OP_READ:
+			r = o.off<0?::read(o.fd, o.buf, o.len): ::pread(o.fd, o.buf, o.len, (off_t)o.off);
+			break;
+		case OP_WRITE:
+			r = o.off<0?::write(o.fd, o.buf, o.len): ::pwrite(o.fd, o.buf, o.len, (off_t)o.off);
+			break;
+		case OP_SPLICE:
+	#ifdef __linux__
+			{
+				loff_t off_in = o.off2, off_out = o.off;
+				r = ::splice(o.fd2, o.off2<0?0:&off_in, o.fd, o.off<0?0:&off_out, o.len, 0);
+			}
+	#else
+			errno = ENOSYS;
+	#endif
+			break;
+#endif
+		}
+		c.res = r<0?-errno:(int)r;
+		done_.push_back(c);
+	}
+
+#ifdef WUYA_HAS_IO_URING
+	inline bool io_engine::setup(unsigned entries) {
+		io_uring_params p;
+		memset(&p, 0, sizeof p);
+		ring_fd_ = (int)syscall(__NR_io_uring_setup, entries, &p);
+		if (ring_fd_ < 0) {
+			return false;
+		}
+		sq_entries_ = p.sq_entries;
+		sq_ring_size_ = p.sq_off.array+p.sq_entries*sizeof(unsigned);
+		cq_ring_size_ = p.cq_off.cqes+p.cq_entries*sizeof(io_uring_cqe);
+		if (p.features & IORING_FEAT_SINGLE_MMAP) {
+			if (cq_ring_size_ > sq_ring_size_) {
+				sq_ring_size_ = cq_ring_size_;
+			}
+			cq_ring_size_ = sq_ring_size_;
+		}
+		sq_ring_ = mmap(0, sq_ring_size_, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+						ring_fd_, IORING_OFF_SQ_RING);
+		if (sq_ring_ == MAP_FAILED) {
+			sq_ring_ = 0;
+			return false;
+		}
+		if (p.features & IORING_FEAT_SINGLE_MMAP) {
+			cq_ring_ = sq_ring_;
+		} else {
+			cq_ring_ = mmap(0, cq_ring_size_, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+							ring_fd_, IORING_OFF_CQ_RING);
+			if (cq_ring_ == MAP_FAILED) {
+				cq_ring_ = 0;
+				return false;
+			}
+		}
+		sqes_size_ = p.sq_entries*sizeof(io_uring_sqe);
+		void* sqes = mmap(0, sqes_size_, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+						  ring_fd_, IORING_OFF_SQES);
+		if (sqes == MAP_FAILED) {
+			return false;
+		}
+		sqes_ = (io_uring_sqe*)sqes;
+
+		char* sq = (char*)sq_ring_;
+		sq_head_ = (unsigned*)(sq+p.sq_off.head);
+		sq_tail_ = (unsigned*)(sq+p.sq_off.tail);
+		sq_mask_ = (unsigned*)(sq+p.sq_off.ring_mask);
+		sq_array_ = (unsigned*)(sq+p.sq_off.array);
+		char* cq = (char*)cq_ring_;
+		cq_head_ = (unsigned*)(cq+p.cq_off.head);
+		cq_tail_ = (unsigned*)(cq+p.cq_off.tail);
+		cq_mask_ = (unsigned*)(cq+p.cq_off.ring_mask);
+		cqes_ = (io_uring_cqe*)(cq+p.cq_off.cqes);
+		probe();
+		return true;
+	}
+
+	inline void io_engine::probe() {
+		memset(ops_, 0, sizeof ops_);
+		size_t size = sizeof(io_uring_probe)+256*sizeof(io_uring_probe_op);
+		io_uring_probe* p = (io_uring_probe*)calloc(1, size);
+		if (p != 0 && syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_PROBE, p, 256) == 0) {
+			for (int i=0; i<p->ops_len; ++i) {
+				if (p->ops[i].op < IORING_OP_LAST && (p->ops[i].flags & IO_URING_OP_SUPPORTED)) {
+					ops_[p->ops[i].op] = true;
+				}
+			}
+		} else {
+			// 5.6ǰֲ֧ѯֻȷ5.1еĹ̶д
+			ops_[IORING_OP_READ_FIXED] = true;
+			ops_[IORING_OP_WRITE_FIXED] = true;
+		}
+		free(p);
+	}
+
+	inline int io_engine::opcode(op_type type, int buf_index) {
+		switch (type) {
+		case OP_ACCEPT:
+			return IORING_OP_ACCEPT;
+		case OP_RECV:
+			return IORING_OP_RECV;
+		case OP_SEND:
+			return IORING_OP_SEND;
+		case OP_READ:
+			return buf_index<0?IORING_OP_READ:IORING_OP_READ_FIXED;
+		case OP_WRITE:
+			return buf_index<0?IORING_OP_WRITE:IORING_OP_WRITE_FIXED;
+		default:
+			return IORING_OP_SPLICE;
+		}
+	}
+
+	inline void io_engine::teardown() {
+		if (sqes_ != 0) {
+			munmap(sqes_, sqes_size_);
+			sqes_ = 0;
+		}
+		if (cq_ring_ != 0 && cq_ring_ != sq_ring_) {
+			munmap(cq_ring_, cq_ring_size_);
+		}
+		cq_ring_ = 0;
+		if (sq_ring_ != 0) {
+			munmap(sq_ring_, sq_ring_size_);
+			sq_ring_ = 0;
+		}
+		if (ring_fd_ >= 0) {
+			::close(ring_fd_);
+			ring_fd_ = -1;
+		}
+	}
+
+	inline io_uring_sqe* io_engine::get_sqe() {
+		unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+		if (sqe_tail_-head >= sq_entries_) {
+			return 0;
+		}
+		return &sqes_[sqe_tail_++ & *sq_mask_];
+	}
+
+	inline int io_engine::enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+		int r;
+		do {
+			r = (int)syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, 0, 0);
+		} while (r < 0 && errno == EINTR);
+		return r;
+	}
+
+	// ɶе¼Ƶdone_ڳɶ
+	inline int io_engine::reap() {
+		unsigned head = *cq_head_;
+		unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+		int n = 0;
+		while (head != tail) {
+			io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+			io_completion c;
+			c.user_data = cqe.user_data;
+			c.res = cqe.res;
+			done_.push_back(c);
+			++head;
+			++n;
+		}
+		__atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+		return n;
+	}
+#endif
+}
+
+#endif
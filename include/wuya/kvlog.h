@@ -0,0 +1,561 @@
+#ifndef __WUYA_KVLOG_H__
+#define __WUYA_KVLOG_H__
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <wuya/ace_log.h>
+#include <wuya/timespan.h>
+
+#if !defined(WUYA_SNPRINTF)
+	#if defined(_MSC_VER)
+		#define WUYA_SNPRINTF _snprintf
+	#else
+		#define WUYA_SNPRINTF snprintf
+	#endif
+#endif
+
+namespace wuya{
+	/**
+	 * ṹ־
+	 * ÿ־ΪһϢɴ͵ֶΣд־ֻ߳ԭʼֽڣ
+	 * ̣߳json_output_typeתΪÿһJSON
+	 *   {"ts":"2024-01-02 03:04:05.678","level":"INFO","msg":"login","uid":42,"user":"bob"}
+	 * ΰJSONʽıС
+	 *
+	 * ÷
+	 *   #define KVLOGSTREAM logstream<json_output_type>
+	 *   KVLOGSTREAM::init(DAY_CHANGE, "log/app$DATE.json");
+	 *   kvinfo_cout("login") << kv("uid", uid) << kv("user", name) << kv_usec("cost", us);
+	 *
+	 * ͨı־loginfo_coutȣдͬһlogstreamʱҲתΪJSONֶֻtslevelmsg
+	 * ַԭֻתšбܺͿַҪUTF-8ʱUTF-8д롣
+	 *
+	 * @author wuya
+	 */
+
+	// ֶͱ
+	enum KVLOG_FIELD_TYPE {
+		KV_INT = 'i',
+		KV_UINT = 'u',
+		KV_DOUBLE = 'd',
+		KV_BOOL = 'b',
+		KV_STRING = 's',
+		// ʱ΢
+		KV_DURATION = 't'
+	};
+
+	/**
+	 * ¼ͷΪϢ2ֽڳȼݣ͸ֶΣдʱmemcpyҪ
+	 * ֶΪͱǡ1ֽڼֵʱΪ8ֽڣΪ1ֽڣ
+	 * ַΪ2ֽڳȼ
+	 */
+	struct kvlog_header {
+		// KVLOG_MARKERı
+		unsigned char marker;
+		unsigned char level;
+		// ¼ֽ¼ͷ
+		unsigned short size;
+		// 1970΢
+		long long usec;
+	};
+
+	enum { KVLOG_MARKER = 0x1e };
+
+	/**
+	 * һֶΣkv()죬ֻڵ־Ч
+	 */
+	struct kv_field {
+		const char* key;
+		char type;
+		long long i;
+		double d;
+		const char* str;
+		size_t len;
+	};
+
+	kv_field kv(const char* key, bool v);
+	kv_field kv(const char* key, short v);
+	kv_field kv(const char* key, unsigned short v);
+	kv_field kv(const char* key, int v);
+	kv_field kv(const char* key, unsigned int v);
+	kv_field kv(const char* key, long v);
+	kv_field kv(const char* key, unsigned long v);
+	kv_field kv(const char* key, long long v);
+	kv_field kv(const char* key, unsigned long long v);
+	kv_field kv(const char* key, float v);
+	kv_field kv(const char* key, double v);
+	kv_field kv(const char* key, const char* v);
+	kv_field kv(const char* key, const std::string& v);
+	// ʱΪ΢
+	kv_field kv(const char* key, const timespan& v);
+	kv_field kv_usec(const char* key, long long usec);
+
+	/**
+	 * ֶα룬MAX_SIZEֶαַض
+	 */
+	class kvlog_args {
+	public:
+		enum { MAX_SIZE = 1024 };
+		kvlog_args(LOGLEVEL level, const char* msg);
+		kvlog_args(LOGLEVEL level, const std::string& msg);
+		kvlog_args& operator<<(const kv_field& f);
+	protected:
+		void begin(LOGLEVEL level, const char* msg, size_t len);
+		bool put_key(char type, const char* key, size_t n);
+		void put_string(const char* s, size_t n);
+
+		char buf_[MAX_SIZE];
+		size_t size_;
+		LOGLEVEL level_;
+	private:
+		kvlog_args(const kvlog_args& );
+		kvlog_args& operator=(const kvlog_args& );
+	};
+
+	// WUYA_KVLOG־Ϊvoidʽ
+	void operator&(log_voidify, const kvlog_args& );
+
+	/**
+	 * һ־ãʱѼ¼stream_type־
+	 */
+	template<class stream_type>
+	class kvlog_record : public kvlog_args {
+	public:
+		kvlog_record(LOGLEVEL level, const char* msg);
+		kvlog_record(LOGLEVEL level, const std::string& msg);
+		~kvlog_record();
+	};
+
+	// ׷JSONַݣţתֽһο
+	void json_escape(const char* s, size_t n, std::string& out);
+	void json_append_int(long long v, std::string& out);
+	void json_append_uint(unsigned long long v, std::string& out);
+	// NaNΪnull
+	void json_append_double(double v, std::string& out);
+
+	/**
+	 * JSONÿ־һУļд뼰file_output_typeͬ
+	 */
+	class json_output_type {
+	public:
+		bool write(const std::string& msg);
+		bool flush(bool force=true);
+		bool sync();
+		bool pending() const;
+		int flush_interval() const;
+		bool open(const char* name);
+		void close();
+	private:
+		// д"{"ts":"...","level":"...","msg":"
+		void begin(int level, const char* ts, size_t ts_len);
+		bool write_record(const char* rec, size_t len);
+		bool write_text(const std::string& msg);
+
+		file_output_type file_;
+		std::string line_;
+	};
+}
+
+#ifndef KVLOGSTREAM
+	#define KVLOGSTREAM wuya::logstream<wuya::json_output_type>
+#endif
+
+// WUYA_LOG_IFһһʽڲŵif
+#define WUYA_KVLOG(level, cond, msg) \
+	( (level) > WUYA_LOG_MIN_LEVEL || !(cond) ) ? (void)0 : \
+		wuya::log_voidify() & wuya::kvlog_record<KVLOGSTREAM >(level, msg)
+
+#define kverr_cout(msg) WUYA_KVLOG(wuya::LOG_ERROR, wuya::log_module::global_enabled(wuya::LOG_ERROR), msg)
+#define kvwarn_cout(msg) WUYA_KVLOG(wuya::LOG_WARN, wuya::log_module::global_enabled(wuya::LOG_WARN), msg)
+#define kvinfo_cout(msg) WUYA_KVLOG(wuya::LOG_INFO, wuya::log_module::global_enabled(wuya::LOG_INFO), msg)
+#define kvdbg_cout(msg) WUYA_KVLOG(wuya::LOG_DEBUG, wuya::log_module::global_enabled(wuya::LOG_DEBUG), msg)
+
+//.............................ʵֲ.............................//
+namespace wuya{
+	inline kv_field kv_int(const char* key, char type, long long v) {
+		kv_field f = {key, type, v, 0, 0, 0};
+		return f;
+	}
+
+	inline kv_field kv(const char* key, bool v) {
+		return kv_int(key, KV_BOOL, v);
+	}
+
+	inline kv_field kv(const char* key, short v) {
+		return kv_int(key, KV_INT, v);
+	}
+
+	inline kv_field kv(const char* key, unsigned short v) {
+		return kv_int(key, KV_INT, v);
+	}
+
+	inline kv_field kv(const char* key, int v) {
+		return kv_int(key, KV_INT, v);
+	}
+
+	inline kv_field kv(const char* key, unsigned int v) {
+		return kv_int(key, KV_INT, v);
+	}
+
+	inline kv_field kv(const char* key, long v) {
+		return kv_int(key, KV_INT, v);
+	}
+
+	inline kv_field kv(const char* key, unsigned long v) {
+		return kv_int(key, KV_UINT, (long long)v);
+	}
+
+	inline kv_field kv(const char* key, long long v) {
+		return kv_int(key, KV_INT, v);
+	}
+
+	inline kv_field kv(const char* key, unsigned long long v) {
+		return kv_int(key, KV_UINT, (long long)v);
+	}
+
+	inline kv_field kv(const char* key, float v) {
+		return kv(key, (double)v);
+	}
+
+	inline kv_field kv(const char* key, double v) {
+		kv_field f = {key, KV_DOUBLE, 0, v, 0, 0};
+		return f;
+	}
+
+	inline kv_field kv(const char* key, const char* v) {
+		kv_field f = {key, KV_STRING, 0, 0, v?v:"", v?strlen(v):0};
+		return f;
+	}
+
+	inline kv_field kv(const char* key, const std::string& v) {
+		kv_field f = {key, KV_STRING, 0, 0, v.data(), v.size()};
+		return f;
+	}
+
+	inline kv_field kv(const char* key, const timespan& v) {
+		return kv_usec(key, v.get_total_microseconds());
+	}
+
+	inline kv_field kv_usec(const char* key, long long usec) {
+		return kv_int(key, KV_DURATION, usec);
+	}
+
+	inline void operator&(log_voidify, const kvlog_args& ) {
+	}
+
+	inline kvlog_args::kvlog_args(LOGLEVEL level, const char* msg) {
+		begin(level, msg, strlen(msg));
+	}
+
+	inline kvlog_args::kvlog_args(LOGLEVEL level, const std::string& msg) {
+		begin(level, msg.data(), msg.size());
+	}
+
+	inline void kvlog_args::begin(LOGLEVEL level, const char* msg, size_t len) {
+		level_ = level;
+		kvlog_header h;
+		h.marker = KVLOG_MARKER;
+		h.level = (unsigned char)level;
+		h.size = 0;
+		std::time_t sec;
+		long usec;
+		log_clock::now(sec, usec);
+		h.usec = (long long)sec*1000000+usec;
+		memcpy(buf_, &h, sizeof h);
+		size_ = sizeof h;
+		put_string(msg, len);
+	}
+
+	inline bool kvlog_args::put_key(char type, const char* key, size_t n) {
+		if (n > 255) {
+			n = 255;
+		}
+		if (size_+2+n+sizeof(long long) > MAX_SIZE) {
+			return false;
+		}
+		buf_[size_++] = type;
+		buf_[size_++] = (char)(unsigned char)n;
+		memcpy(buf_+size_, key, n);
+		size_ += n;
+		return true;
+	}
+
+	inline void kvlog_args::put_string(const char* s, size_t n) {
+		unsigned short len = 0;
+		if (size_+sizeof len <= MAX_SIZE) {
+			len = (unsigned short)(n<MAX_SIZE-size_-sizeof len?n:MAX_SIZE-size_-sizeof len);
+		}
+		memcpy(buf_+size_, &len, sizeof len);
+		memcpy(buf_+size_+sizeof len, s, len);
+		size_ += sizeof len+len;
+	}
+
+	inline kvlog_args& kvlog_args::operator<<(const kv_field& f) {
+		if (!put_key(f.type, f.key, strlen(f.key))) {
+			return *this;
+		}
+		switch (f.type) {
+		case KV_BOOL:
+			buf_[size_++] = f.i?1:0;
+			break;
+		case KV_DOUBLE:
+			memcpy(buf_+size_, &f.d, sizeof f.d);
+			size_ += sizeof f.d;
+			break;
+		case KV_STRING:
+			put_string(f.str, f.len);
+			break;
+		default:
+			memcpy(buf_+size_, &f.i, sizeof f.i);
+			size_ += sizeof f.i;
+			break;
+		}
+		return *this;
+	}
+
+	template<class stream_type>
+	inline kvlog_record<stream_type>::kvlog_record(LOGLEVEL level, const char* msg):kvlog_args(level, msg) {
+	}
+
+	template<class stream_type>
+	inline kvlog_record<stream_type>::kvlog_record(LOGLEVEL level, const std::string& msg):
+	kvlog_args(level, msg) {
+	}
+
+	template<class stream_type>
+	inline kvlog_record<stream_type>::~kvlog_record() {
+		unsigned short size = (unsigned short)size_;
+		memcpy(buf_+offsetof(kvlog_header, size), &size, sizeof size);
+		stream_type::submit(buf_, size_, level_);
+	}
+
+	inline void json_escape(const char* s, size_t n, std::string& out) {
+		// 0ת壬'u'Ϊ\u00XXΪбַܺ
+		static const char table[256] = {
+			'u','u','u','u','u','u','u','u','b','t','n','u','f','r','u','u',
+			'u','u','u','u','u','u','u','u','u','u','u','u','u','u','u','u',
+			0,0,'"',0,0,0,0,0,0,0,0,0,0,0,0,0,
+			0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+			0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+			0,0,0,0,0,0,0,0,0,0,0,0,'\\',0,0,0
+		};
+		static const char hex[] = "0123456789abcdef";
+		const char* end = s+n;
+		while (s < end) {
+			const char* run = s;
+			while (s < end && table[(unsigned char)*s] == 0) {
+				++s;
+			}
+			out.append(run, s-run);
+			if (s == end) {
+				break;
+			}
+			char esc[6] = {'\\', table[(unsigned char)*s], '0', '0', 0, 0};
+			if (esc[1] == 'u') {
+				esc[4] = hex[(unsigned char)*s>>4];
+				esc[5] = hex[*s & 0xF];
+				out.append(esc, 6);
+			} else {
+				out.append(esc, 2);
+			}
+			++s;
+		}
+	}
+
+	inline void json_append_uint(unsigned long long v, std::string& out) {
+		char buf[24];
+		char* p = buf+sizeof buf;
+		do {
+			*--p = (char)('0'+v%10);
+			v /= 10;
+		} while (v != 0);
+		out.append(p, buf+sizeof buf-p);
+	}
+
+	inline void json_append_int(long long v, std::string& out) {
+		if (v < 0) {
+			out += '-';
+			json_append_uint(0-(unsigned long long)v, out);
+		} else {
+			json_append_uint((unsigned long long)v, out);
+		}
+	}
+
+	inline void json_append_double(double v, std::string& out) {
+		// NaNȥΪNaN
+		if (v != v || v-v != 0) {
+			out += "null";
+			return;
+		}
+		char buf[32];
+		int n = WUYA_SNPRINTF(buf, sizeof buf, "%.15g", v);
+		if (n > 0 && n < (int)sizeof buf) {
+			out.append(buf, n);
+		} else {
+			out += "null";
+		}
+	}
+
+	inline void json_output_type::begin(int level, const char* ts, size_t ts_len) {
+		// Ԥƴõֶβ
+		static const char* const layout[] = {
+			"\",\"level\":\"ERROR\",\"msg\":\"",
+			"\",\"level\":\"WARN\",\"msg\":\"",
+			"\",\"level\":\"INFO\",\"msg\":\"",
+			"\",\"level\":\"DEBUG\",\"msg\":\""
+		};
+		line_.assign("{\"ts\":\"", 7);
+		line_.append(ts, ts_len);
+		line_ += layout[level>=LOG_ERROR && level<=LOG_DEBUG?level:LOG_INFO];
+	}
+
+	inline bool json_output_type::write(const std::string& msg) {
+		if (!msg.empty() && (unsigned char)msg[0] == KVLOG_MARKER) {
+			return write_record(msg.data(), msg.size());
+		}
+		return write_text(msg);
+	}
+
+	inline bool json_output_type::write_record(const char* rec, size_t len) {
+		kvlog_header h;
+		if (len < sizeof h+2) {
+			return false;
+		}
+		memcpy(&h, rec, sizeof h);
+		char ts[log_clock::MAX_LEN];
+		int ts_len = log_clock::format(ts, (std::time_t)(h.usec/1000000), (long)(h.usec%1000000));
+		begin(h.level, ts, ts_len);
+		const char* p = rec+sizeof h;
+		const char* end = rec+(h.size<len?h.size:len);
+		unsigned short n;
+		memcpy(&n, p, sizeof n);
+		p += sizeof n;
+		if (n > end-p) {
+			n = (unsigned short)(end-p);
+		}
+		json_escape(p, n, line_);
+		line_ += '"';
+		p += n;
+		while (end-p >= 2) {
+			char type = p[0];
+			size_t key_len = (unsigned char)p[1];
+			p += 2;
+			if ((size_t)(end-p) < key_len) {
+				break;
+			}
+			line_ += ",\"";
+			json_escape(p, key_len, line_);
+			line_ += "\":";
+			p += key_len;
+			long long i;
+			double d;
+			if (type == KV_BOOL) {
+				if (end-p < 1) {
+					break;
+				}
+				line_ += *p?"true":"false";
+				p += 1;
+				continue;
+			}
+			if (type == KV_STRING) {
+				if (end-p < (ptrdiff_t)sizeof n) {
+					break;
+				}
+				memcpy(&n, p, sizeof n);
+				p += sizeof n;
+				if (n > end-p) {
+					n = (unsigned short)(end-p);
+				}
+				line_ += '"';
+				json_escape(p, n, line_);
+				line_ += '"';
+				p += n;
+				continue;
+			}
+			if (end-p < (ptrdiff_t)sizeof i) {
+				break;
+			}
+			switch (type) {
+			case KV_DOUBLE:
+				memcpy(&d, p, sizeof d);
+				json_append_double(d, line_);
+				break;
+			case KV_UINT:
+				memcpy(&i, p, sizeof i);
+				json_append_uint((unsigned long long)i, line_);
+				break;
+			default:
+				memcpy(&i, p, sizeof i);
+				json_append_int(i, line_);
+				break;
+			}
+			p += sizeof i;
+		}
+		if (line_[line_.size()-1] == ':') {
+			// ¼һֶûֵ
+			line_ += "null";
+		}
+		line_ += "}\n";
+		return file_.write(line_);
+	}
+
+	inline bool json_output_type::write_text(const std::string& msg) {
+		// ıΪ"(8ַ) ʱ Ϣ"
+		size_t len = msg.size();
+		if (len > 0 && msg[len-1] == '\n') {
+			--len;
+		}
+		int level = -1;
+		for (int l=LOG_ERROR; l<=LOG_DEBUG && len>=8; ++l) {
+			if (memcmp(msg.data(), level_name((LOGLEVEL)l), 8) == 0) {
+				level = l;
+				break;
+			}
+		}
+		size_t ts_end = std::string::npos;
+		if (level >= 0) {
+			size_t sp = msg.find(' ', 9);
+			if (sp != std::string::npos && sp < len) {
+				ts_end = msg.find(' ', sp+1);
+			}
+		}
+		if (ts_end == std::string::npos || ts_end >= len) {
+			char ts[log_clock::MAX_LEN];
+			begin(level<0?LOG_INFO:level, ts, log_clock::format_now(ts));
+			json_escape(msg.data(), len, line_);
+		} else {
+			begin(level, msg.data()+8, ts_end-8);
+			json_escape(msg.data()+ts_end+1, len-ts_end-1, line_);
+		}
+		line_ += "\"}\n";
+		return file_.write(line_);
+	}
+
+	inline bool json_output_type::flush(bool force) {
+		return file_.flush(force);
+	}
+
+	inline bool json_output_type::sync() {
+		return file_.sync();
+	}
+
+	inline bool json_output_type::pending() const {
+		return file_.pending();
+	}
+
+	inline int json_output_type::flush_interval() const {
+		return file_.flush_interval();
+	}
+
+	inline bool json_output_type::open(const char* name) {
+		return file_.open(name);
+	}
+
+	inline void json_output_type::close() {
+		file_.close();
+	}
+}
+
+#endif
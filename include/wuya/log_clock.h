@@ -0,0 +1,175 @@
+#ifndef __WUYA_LOG_CLOCK_H__
+#define __WUYA_LOG_CLOCK_H__
+
+#include <ctime>
+#include <wuya/tls.h>
+#if defined(WIN32)||defined(_WIN32)
+	#define _WINSOCKAPI_
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
+namespace wuya{
+	/**
+	 * ־ʱĿٸʽ
+	 * ÿ̻߳Ѹʽ"yyyy-mm-dd hh:mm:ss"ÿֻһlocaltime
+	 * ͬһֻд΢֡Linuxº뾫ʹCLOCK_REALTIME_COARSE
+	 * ںˣ΢뾫ʹCLOCK_REALTIME
+	 *
+	 * @author wuya
+	 */
+	class log_clock {
+	public:
+		// "yyyy-mm-dd hh:mm:ss.uuuuuu"ĳ
+		enum { MAX_LEN = 26 };
+		/**
+		 * µλ߳Ч
+		 *
+		 * @param digits 03ȱʡ6
+		 */
+		static void set_precision(int digits);
+		static int precision();
+		/**
+		 * ǰʱʽΪ"yyyy-mm-dd hh:mm:ss.mmm"дbufдβ0
+		 *
+		 * @param buf    MAX_LENַ
+		 *
+		 * @return дַ
+		 */
+		static int format_now(char* buf);
+		// ʽʱ䣬ͬʹñ̵߳Ļ
+		static int format(char* buf, std::time_t sec, long usec);
+		// ǰʱ䣬Ȳںʱʹôʱ
+		static void now(std::time_t& sec, long& usec);
+		// ʱӣLinuxΪ룬WindowsΪQueryPerformanceCounterļ
+		static long long ticks();
+		// ticks()ÿļ
+		static long long ticks_per_sec();
+	private:
+		struct cache {
+			std::time_t sec;
+			char text[20];
+		};
+		static int& precision_ref();
+		static void put_digits(char* p, int n, int width);
+	};
+}
+
+//.............................ʵֲ.............................//
+namespace wuya{
+	inline int& log_clock::precision_ref() {
+		static int digits = 3;
+		return digits;
+	}
+
+	inline void log_clock::set_precision(int digits) {
+		precision_ref() = digits>3?6:(digits>0?3:0);
+	}
+
+	inline int log_clock::precision() {
+		return precision_ref();
+	}
+
+	inline void log_clock::now(std::time_t& sec, long& usec) {
+#if defined(WIN32)||defined(_WIN32)
+		FILETIME ft;
+		GetSystemTimeAsFileTime(&ft);
+		// 1601-01-01100ns
+		unsigned __int64 t = ((unsigned __int64)ft.dwHighDateTime<<32)|ft.dwLowDateTime;
+		t -= 116444736000000000ui64;
+		sec = (std::time_t)(t/10000000);
+		usec = (long)(t%10000000/10);
+#else
+		timespec ts;
+	#ifdef CLOCK_REALTIME_COARSE
+		clock_gettime(precision()>3?CLOCK_REALTIME:CLOCK_REALTIME_COARSE, &ts);
+	#else
+		clock_gettime(CLOCK_REALTIME, &ts);
+	#endif
+		sec = ts.tv_sec;
+		usec = ts.tv_nsec/1000;
+#endif
+	}
+
+	inline long long log_clock::ticks() {
+#if defined(WIN32)||defined(_WIN32)
+		LARGE_INTEGER t;
+		QueryPerformanceCounter(&t);
+		return t.QuadPart;
+#else
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (long long)ts.tv_sec*1000000000+ts.tv_nsec;
+#endif
+	}
+
+	inline long long log_clock::ticks_per_sec() {
+#if defined(WIN32)||defined(_WIN32)
+		static long long freq = 0;
+		if (freq == 0) {
+			LARGE_INTEGER f;
+			QueryPerformanceFrequency(&f);
+			freq = f.QuadPart;
+		}
+		return freq;
+#else
+		return 1000000000;
+#endif
+	}
+
+	inline void log_clock::put_digits(char* p, int n, int width) {
+		for (int i=width-1; i>=0; --i) {
+			p[i] = (char)('0'+n%10);
+			n /= 10;
+		}
+	}
+
+	inline int log_clock::format_now(char* buf) {
+		std::time_t sec;
+		long usec;
+		now(sec, usec);
+		return format(buf, sec, usec);
+	}
+
+	inline int log_clock::format(char* buf, std::time_t sec, long usec) {
+		static WUYA_TLS cache c = {0, {0}};
+		if (sec != c.sec || c.text[0] == 0) {
+			tm t;
+#if defined(WIN32)||defined(_WIN32)
+			localtime_s(&t, &sec);
+#else
+			localtime_r(&sec, &t);
+#endif
+			char* p = c.text;
+			put_digits(p, t.tm_year+1900, 4);
+			p[4] = '-';
+			put_digits(p+5, t.tm_mon+1, 2);
+			p[7] = '-';
+			put_digits(p+8, t.tm_mday, 2);
+			p[10] = ' ';
+			put_digits(p+11, t.tm_hour, 2);
+			p[13] = ':';
+			put_digits(p+14, t.tm_min, 2);
+			p[16] = ':';
+			put_digits(p+17, t.tm_sec, 2);
+			c.sec = sec;
+		}
+		for (int i=0; i<19; ++i) {
+			buf[i] = c.text[i];
+		}
+		int digits = precision();
+		if (digits == 0) {
+			return 19;
+		}
+		buf[19] = '.';
+		if (digits == 3) {
+			put_digits(buf+20, (int)(usec/1000), 3);
+		} else {
+			put_digits(buf+20, (int)usec, 6);
+		}
+		return 20+digits;
+	}
+}
+
+#endif
@@ -0,0 +1,514 @@
+#ifndef __WUYA_LOG_SINK_H__
+#define __WUYA_LOG_SINK_H__
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <wuya/ace_log.h>
+#if !defined(WIN32)&&!defined(_WIN32)
+	#include <wuya/socket.h>
+#endif
+
+namespace wuya{
+	/**
+	 * ־Ŀ
+	 * һϢֻʽһΣsink_output_typeַĿ꣬ÿĿиԵļͻ巽ʽ
+	 * ֻ־߳еá
+	 *
+	 * ÷
+	 *   #define LOGSTREAM logstream<sink_output_type>
+	 *   // init֮ǰӣinit֮ĵһϢдĿꣻfile_sinkloggerļ
+	 *   sink_output_type::add_default(new file_sink(LOG_DEBUG));
+	 *   sink_output_type::add_default(new stdout_sink(LOG_WARN));
+	 *   LOGSTREAM::init(DAY_CHANGE, "log/app$DATE.log");
+	 *   // Ҳӣ֮ǰϢдĿ
+	 *   LOGSTREAM::output_type().add(new memory_sink());
+	 *
+	 * @author wuya
+	 */
+	class log_sink {
+	public:
+		explicit log_sink(LOGLEVEL level=LOG_DEBUG);
+		virtual ~log_sink();
+		// 𲻸level()Ϣд
+		LOGLEVEL level() const;
+		void set_level(LOGLEVEL level);
+	public:
+		virtual bool write(const std::string& msg, LOGLEVEL level) = 0;
+		virtual bool flush(bool force);
+		virtual bool sync();
+		virtual bool pending() const;
+		virtual int flush_interval() const;
+		// logger򿪻ļʱãnameΪloggerǰļ
+		virtual bool open(const char* name);
+		virtual void close();
+	private:
+		volatile long level_;
+	private:
+		log_sink(const log_sink& );
+		log_sink& operator=(const log_sink& );
+	};
+
+	/**
+	 * еԣfile_output_typecout_output_typeȣΪĿ
+	 */
+	template<class Op_>
+	class policy_sink : public log_sink {
+	public:
+		/**
+		 * @param level  
+		 * @param name   ļΪ0ʱʹloggerļ֮
+		 */
+		explicit policy_sink(LOGLEVEL level=LOG_DEBUG, const char* name=0);
+		virtual bool write(const std::string& msg, LOGLEVEL level);
+		virtual bool flush(bool force);
+		virtual bool sync();
+		virtual bool pending() const;
+		virtual int flush_interval() const;
+		virtual bool open(const char* name);
+		virtual void close();
+		Op_& output_type();
+	private:
+		Op_ op_;
+		std::string name_;
+		bool fixed_;
+		bool opened_;
+	};
+
+	typedef policy_sink<file_output_type> file_sink;
+	typedef policy_sink<cout_output_type> stdout_sink;
+
+#if !defined(WIN32)&&!defined(_WIN32)
+	/**
+	 * unixݱ׽д뱾syslogʽΪRFC3164"<PRI>TAG: MSG"
+	 * ʱsyslogػ
+	 */
+	class syslog_sink : public log_sink {
+	public:
+		enum {
+			// ȱʡfacilityΪLOG_USER
+			FACILITY_USER = 1,
+			FACILITY_LOCAL0 = 16
+		};
+		/**
+		 * @param tag      
+		 * @param level    
+		 * @param facility syslogfacility
+		 * @param path     syslog׽
+		 */
+		explicit syslog_sink(const char* tag, LOGLEVEL level=LOG_INFO, int facility=FACILITY_USER,
+							 const char* path="/dev/log");
+		virtual ~syslog_sink();
+		virtual bool write(const std::string& msg, LOGLEVEL level);
+	private:
+		bool connect();
+
+		std::string tag_;
+		int facility_;
+		unix_addr addr_;
+		int fd_;
+		std::string buf_;
+	};
+#endif
+
+	/**
+	 * ڴеĻλдcapacityֽڣڱʱת
+	 * capacityΪ0ʱ1
+	 */
+	class memory_sink : public log_sink {
+	public:
+		explicit memory_sink(size_t capacity=1024*1024, LOGLEVEL level=LOG_DEBUG);
+		virtual ~memory_sink();
+		virtual bool write(const std::string& msg, LOGLEVEL level);
+		// ʱ˳ȡ
+		std::string dump() const;
+		/**
+		 * дfdֻwriteźŴʹ
+		 *
+		 * @return ɹ0ʧܷ-1
+		 */
+		int dump(int fd) const;
+	private:
+		char* buf_;
+		size_t capacity_;
+		// ´дλ
+		volatile long pos_;
+		bool wrapped_;
+	};
+
+	/**
+	 * ĿԣϢνĸĿ
+	 */
+	class sink_output_type {
+	public:
+		sink_output_type();
+		~sink_output_type();
+		// Ŀ꣬sinksink_output_typeͷţ־е
+		void add(log_sink* sink);
+		/**
+		 * logstream::init֮ǰĿ꣬initȡȫӵĿ
+		 * ֻӦinit֮ǰĵ߳е
+		 */
+		static void add_default(log_sink* sink);
+		bool write(const std::string& msg, LOGLEVEL level);
+		// loggerʾLOG_WARN
+		bool write(const std::string& msg);
+		bool flush(bool force=true);
+		bool sync();
+		bool pending() const;
+		int flush_interval() const;
+		bool open(const char* name);
+		void close();
+	private:
+		static std::vector<log_sink*>& defaults();
+
+		std::vector<log_sink*> sinks_;
+		// sinks_addʱ߳̾
+		mutable ACE_Thread_Mutex mutex_;
+		std::string name_;
+		bool opened_;
+	private:
+		sink_output_type(const sink_output_type& );
+		sink_output_type& operator=(const sink_output_type& );
+	};
+
+	template<>
+	struct output_traits<sink_output_type> {
+		enum { direct = 0 };
+		static bool write(sink_output_type& op, const std::string& msg, LOGLEVEL level);
+		static bool write_direct(sink_output_type& op, const char* msg, size_t len, LOGLEVEL level);
+	};
+}
+
+//.............................ʵֲ.............................//
+namespace wuya{
+	inline log_sink::log_sink(LOGLEVEL level):level_(level) {
+	}
+
+	inline log_sink::~log_sink() {
+	}
+
+	inline LOGLEVEL log_sink::level() const {
+		return (LOGLEVEL)atomic_load(&level_);
+	}
+
+	inline void log_sink::set_level(LOGLEVEL level) {
+		atomic_store(&level_, level);
+	}
+
+	inline bool log_sink::flush(bool force) {
+		return true;
+	}
+
+	inline bool log_sink::sync() {
+		return flush(true);
+	}
+
+	inline bool log_sink::pending() const {
+		return false;
+	}
+
+	inline int log_sink::flush_interval() const {
+		return 0;
+	}
+
+	inline bool log_sink::open(const char* name) {
+		return true;
+	}
+
+	inline void log_sink::close() {
+	}
+
+	template<class Op_>
+	inline policy_sink<Op_>::policy_sink(LOGLEVEL level, const char* name):log_sink(level),
+	name_(name?name:""),fixed_(name!=0),opened_(false) {
+	}
+
+	template<class Op_>
+	inline bool policy_sink<Op_>::write(const std::string& msg, LOGLEVEL level) {
+		return op_.write(msg);
+	}
+
+	template<class Op_>
+	inline bool policy_sink<Op_>::flush(bool force) {
+		return op_.flush(force);
+	}
+
+	template<class Op_>
+	inline bool policy_sink<Op_>::sync() {
+		return op_.sync();
+	}
+
+	template<class Op_>
+	inline bool policy_sink<Op_>::pending() const {
+		return op_.pending();
+	}
+
+	template<class Op_>
+	inline int policy_sink<Op_>::flush_interval() const {
+		return op_.flush_interval();
+	}
+
+	template<class Op_>
+	inline bool policy_sink<Op_>::open(const char* name) {
+		// ָļʱֻһΣlogger
+		if (fixed_) {
+			if (!opened_) {
+				make_dir(wuya::filestat(name_.c_str()).get_filepath());
+				opened_ = op_.open(name_.c_str());
+			}
+			return opened_;
+		}
+		opened_ = op_.open(name);
+		return opened_;
+	}
+
+	template<class Op_>
+	inline void policy_sink<Op_>::close() {
+		if (fixed_) {
+			op_.flush(true);
+			return;
+		}
+		op_.close();
+		opened_ = false;
+	}
+
+	template<class Op_>
+	inline Op_& policy_sink<Op_>::output_type() {
+		return op_;
+	}
+
+#if !defined(WIN32)&&!defined(_WIN32)
+	inline syslog_sink::syslog_sink(const char* tag, LOGLEVEL level, int facility, const char* path):
+	log_sink(level),tag_(tag),facility_(facility),addr_(path),fd_(-1) {
+		connect();
+	}
+
+	inline syslog_sink::~syslog_sink() {
+		if (fd_ >= 0) {
+			::close(fd_);
+		}
+	}
+
+	inline bool syslog_sink::connect() {
+		if (fd_ >= 0) {
+			::close(fd_);
+		}
+		fd_ = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+		if (fd_ < 0) {
+			return false;
+		}
+		if (::connect(fd_, (sockaddr*)addr_.get_addr(), addr_.get_size()) != 0) {
+			::close(fd_);
+			fd_ = -1;
+			return false;
+		}
+		return true;
+	}
+
+	inline bool syslog_sink::write(const std::string& msg, LOGLEVEL level) {
+		// syslogseverity3 err4 warning6 info7 debug
+		static const int severity[] = {3, 4, 6, 7};
+		char pri[16];
+		int n = sprintf(pri, "<%d>", facility_*8+severity[level]);
+		buf_.assign(pri, n);
+		buf_ += tag_;
+		buf_ += ": ";
+		size_t len = msg.size();
+		if (len > 0 && msg[len-1] == '\n') {
+			--len;
+		}
+		buf_.append(msg.data(), len);
+		for (int i=0; i<2; ++i) {
+			if (fd_ >= 0 && ::send(fd_, buf_.data(), buf_.size(), 0) >= 0) {
+				return true;
+			}
+			// syslogػ
+			if (!connect()) {
+				break;
+			}
+		}
+		return false;
+	}
+#endif
+
+	inline memory_sink::memory_sink(size_t capacity, LOGLEVEL level):log_sink(level),
+	capacity_(capacity>0?capacity:1),pos_(0),wrapped_(false) {
+		buf_ = new char[capacity_];
+	}
+
+	inline memory_sink::~memory_sink() {
+		delete [] buf_;
+	}
+
+	inline bool memory_sink::write(const std::string& msg, LOGLEVEL level) {
+		const char* p = msg.data();
+		size_t len = msg.size();
+		if (len >= capacity_) {
+			p += len-capacity_;
+			len = capacity_;
+		}
+		size_t pos = (size_t)pos_;
+		size_t first = capacity_-pos<len?capacity_-pos:len;
+		memcpy(buf_+pos, p, first);
+		memcpy(buf_, p+first, len-first);
+		if (pos+len >= capacity_) {
+			wrapped_ = true;
+		}
+		atomic_store(&pos_, (long)((pos+len)%capacity_));
+		return true;
+	}
+
+	inline std::string memory_sink::dump() const {
+		size_t pos = (size_t)atomic_load(&pos_);
+		std::string s;
+		if (wrapped_) {
+			s.assign(buf_+pos, capacity_-pos);
+		}
+		s.append(buf_, pos);
+		return s;
+	}
+
+	inline int memory_sink::dump(int fd) const {
+		size_t pos = (size_t)atomic_load(&pos_);
+		const char* seg[2] = {buf_+pos, buf_};
+		size_t len[2] = {wrapped_?capacity_-pos:0, pos};
+		for (int i=0; i<2; ++i) {
+			while (len[i] > 0) {
+#if defined(WIN32)||defined(_WIN32)
+				int n = ::_write(fd, seg[i], (unsigned int)len[i]);
+#else
+				ssize_t n = ::write(fd, seg[i], len[i]);
+				if (n < 0 && errno == EINTR) {
+					continue;
+				}
+#endif
+				if (n <= 0) {
+					return -1;
+				}
+				seg[i] += n;
+				len[i] -= n;
+			}
+		}
+		return 0;
+	}
+
+	inline sink_output_type::sink_output_type():opened_(false) {
+		sinks_.swap(defaults());
+	}
+
+	inline std::vector<log_sink*>& sink_output_type::defaults() {
+		static std::vector<log_sink*> sinks;
+		return sinks;
+	}
+
+	inline void sink_output_type::add_default(log_sink* sink) {
+		defaults().push_back(sink);
+	}
+
+	inline sink_output_type::~sink_output_type() {
+		for (size_t i=0; i<sinks_.size(); ++i) {
+			delete sinks_[i];
+		}
+	}
+
+	inline void sink_output_type::add(log_sink* sink) {
+		ACE_GUARD(ACE_Thread_Mutex, guard, mutex_);
+		if (opened_) {
+			sink->open(name_.c_str());
+		}
+		sinks_.push_back(sink);
+	}
+
+	inline bool sink_output_type::write(const std::string& msg, LOGLEVEL level) {
+		ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, mutex_, false);
+		bool ret = true;
+		for (size_t i=0; i<sinks_.size(); ++i) {
+			if (level <= sinks_[i]->level() && !sinks_[i]->write(msg, level)) {
+				ret = false;
+			}
+		}
+		return ret;
+	}
+
+	inline bool sink_output_type::write(const std::string& msg) {
+		return write(msg, LOG_WARN);
+	}
+
+	inline bool sink_output_type::flush(bool force) {
+		ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, mutex_, false);
+		bool ret = true;
+		for (size_t i=0; i<sinks_.size(); ++i) {
+			if (!sinks_[i]->flush(force)) {
+				ret = false;
+			}
+		}
+		return ret;
+	}
+
+	inline bool sink_output_type::sync() {
+		ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, mutex_, false);
+		bool ret = true;
+		for (size_t i=0; i<sinks_.size(); ++i) {
+			if (!sinks_[i]->sync()) {
+				ret = false;
+			}
+		}
+		return ret;
+	}
+
+	inline bool sink_output_type::pending() const {
+		ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, mutex_, false);
+		for (size_t i=0; i<sinks_.size(); ++i) {
+			if (sinks_[i]->pending()) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	inline int sink_output_type::flush_interval() const {
+		ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, mutex_, 0);
+		// ȡлĿ̵ļ
+		int interval = -1;
+		for (size_t i=0; i<sinks_.size(); ++i) {
+			if (sinks_[i]->pending() && (interval < 0 || sinks_[i]->flush_interval() < interval)) {
+				interval = sinks_[i]->flush_interval();
+			}
+		}
+		return interval<0?0:interval;
+	}
+
+	inline bool sink_output_type::open(const char* name) {
+		ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, mutex_, false);
+		name_ = name;
+		opened_ = true;
+		bool ret = true;
+		for (size_t i=0; i<sinks_.size(); ++i) {
+			if (!sinks_[i]->open(name)) {
+				ret = false;
+			}
+		}
+		return ret;
+	}
+
+	inline void sink_output_type::close() {
+		ACE_GUARD(ACE_Thread_Mutex, guard, mutex_);
+		for (size_t i=0; i<sinks_.size(); ++i) {
+			sinks_[i]->close();
+		}
+		opened_ = false;
+	}
+
+	inline bool output_traits<sink_output_type>::write(sink_output_type& op, const std::string& msg,
+														LOGLEVEL level) {
+		return op.write(msg, level);
+	}
+
+	inline bool output_traits<sink_output_type>::write_direct(sink_output_type& op, const char* msg, size_t len,
+															   LOGLEVEL level) {
+		return false;
+	}
+}
+
+#endif
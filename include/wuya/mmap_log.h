@@ -0,0 +1,393 @@
+#ifndef __WUYA_MMAP_LOG_H__
+#define __WUYA_MMAP_LOG_H__
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <wuya/ace_log.h>
+#include <wuya/atomic.h>
+#if defined(WIN32)||defined(_WIN32)
+	#define _WINSOCKAPI_
+	#include <windows.h>
+#else
+	#include <unistd.h>
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+namespace wuya{
+	/**
+	 * ڴӳĻ־ļ
+	 * ļͷռһҳΪcapacityֽڵĻд־߳CASԤռ
+	 * ֱдӳڴ棬Сϵͳ̱SIGSEGVabortȣ
+	 * ҳУɲϵͳдļtools/mmaplog2textȡ
+	 * ʱδдصݻᶪʧ
+	 *
+	 * ¼8ֽڶ룬Խĩβ¼ͷcheckֶд룬
+	 * ָʱֻȡcheckȷδǵļ¼дһļ¼ԡ
+	 */
+	struct mmap_log_header {
+		enum { SIZE = 4096, VERSION = 1 };
+		// "WUYAMLOG"
+		char magic[8];
+		unsigned int version;
+		// ֽ2
+		unsigned int capacity;
+		// ۼԤֽƼ
+		volatile long head;
+	};
+
+	struct mmap_log_record {
+		// ¼ۼλã32λ
+		unsigned int pos;
+		// Ϣֽ
+		unsigned short size;
+		unsigned char level;
+		unsigned char flags;
+		volatile long check;
+	};
+
+	// ¼Уֵ
+	long mmap_log_check(unsigned int pos, unsigned short size, unsigned char level);
+
+	/**
+	 * ڴӳ价ļļд󸲸ɵļ¼
+	 * ÷
+	 *   mmap_output_type::defaults().capacity = 16*1024*1024;
+	 *   logstream<mmap_output_type>::init(NEVER_CHANGE, "log/app.mlog");
+	 *
+	 * ļڽڹ̶ڸlog_rotateЧ
+	 * Ѵͬļдǰļ¼
+	 */
+	class mmap_output_type {
+	public:
+		struct config {
+			// ֽȡΪ2
+			unsigned long capacity;
+		};
+		/**
+		 * ȱʡãlogstream::init֮ǰ޸ĲЧ
+		 */
+		static config& defaults();
+
+		mmap_output_type();
+		~mmap_output_type();
+		/**
+		 * дһ¼ڶ߳ͬʱãϢض
+		 *
+		 * @return ļδӳʱfalse
+		 */
+		bool append(const char* msg, size_t len, LOGLEVEL level);
+		// loggerʾLOG_WARN
+		bool write(const std::string& msg);
+		// forceʱ첽дش
+		bool flush(bool force=true);
+		// ͬдش
+		bool sync();
+		bool pending() const;
+		int flush_interval() const;
+		// ֻ״εʱӳļ
+		bool open(const char* name);
+		// ͬдش̣ӳ䱣˺дļ¼ȻЧ
+		void close();
+	private:
+		bool map(const char* name);
+
+		config cfg_;
+		char* base_;
+		size_t size_;
+		mmap_log_header* header_;
+		char* data_;
+		unsigned long mask_;
+		size_t max_msg_;
+		volatile long ready_;
+	private:
+		mmap_output_type(const mmap_output_type& );
+		mmap_output_type& operator=(const mmap_output_type& );
+	};
+
+	template<>
+	struct output_traits<mmap_output_type> {
+		enum { direct = 1 };
+		static bool write(mmap_output_type& op, const std::string& msg, LOGLEVEL level);
+		static bool write_direct(mmap_output_type& op, const char* msg, size_t len, LOGLEVEL level);
+	};
+
+	/**
+	 * ӻ־ļад˳ȡ¼
+	 */
+	class mmap_log_reader {
+	public:
+		mmap_log_reader();
+		/**
+		 * ļλЧ¼
+		 *
+		 * @return ǻ־ļʱfalse
+		 */
+		bool open(const char* name);
+		// Ч¼
+		size_t size() const;
+		// ȡһ¼ȡʱfalse
+		bool next(std::string& msg, LOGLEVEL& level);
+	private:
+		struct entry {
+			// headľ룬ԽԽ
+			unsigned int age;
+			size_t offset;
+			bool operator<(const entry& e) const;
+		};
+		std::vector<char> data_;
+		std::vector<entry> entries_;
+		size_t next_;
+	};
+}
+
+//.............................ʵֲ.............................//
+namespace wuya{
+	inline long mmap_log_check(unsigned int pos, unsigned short size, unsigned char level) {
+		// Ϊ0ȫᱻ¼
+		return (long)((pos^((unsigned int)size<<8|level)^0x574C4F47U)|0x80000000U);
+	}
+
+	inline mmap_output_type::config& mmap_output_type::defaults() {
+		static config cfg = {8*1024*1024};
+		return cfg;
+	}
+
+	inline mmap_output_type::mmap_output_type():cfg_(defaults()),base_(0),size_(0),header_(0),
+	data_(0),mask_(0),max_msg_(0),ready_(0) {
+	}
+
+	inline mmap_output_type::~mmap_output_type() {
+		if (base_ == 0) {
+			return;
+		}
+#if defined(WIN32)||defined(_WIN32)
+		UnmapViewOfFile(base_);
+#else
+		munmap(base_, size_);
+#endif
+	}
+
+	inline bool mmap_output_type::append(const char* msg, size_t len, LOGLEVEL level) {
+		if (!atomic_load(&ready_)) {
+			return false;
+		}
+		if (len > max_msg_) {
+			len = max_msg_;
+		}
+		unsigned long rec = (unsigned long)((sizeof(mmap_log_record)+len+7)&~(size_t)7);
+		unsigned long h, need;
+		do {
+			h = (unsigned long)atomic_load(&header_->head);
+			// Ųʱβʣռ
+			unsigned long off = h & mask_;
+			need = off+rec>mask_+1?mask_+1-off+rec:rec;
+		} while (!atomic_cas(&header_->head, (long)h, (long)(h+need)));
+		unsigned long pos = h+need-rec;
+		char* p = data_+(pos & mask_);
+		memcpy(p+sizeof(mmap_log_record), msg, len);
+		mmap_log_record* r = (mmap_log_record*)p;
+		r->pos = (unsigned int)pos;
+		r->size = (unsigned short)len;
+		r->level = (unsigned char)level;
+		r->flags = 0;
+		atomic_store(&r->check, mmap_log_check(r->pos, r->size, r->level));
+		return true;
+	}
+
+	inline bool mmap_output_type::write(const std::string& msg) {
+		return append(msg.data(), msg.size(), LOG_WARN);
+	}
+
+	inline bool mmap_output_type::flush(bool force) {
+		if (!force || base_ == 0) {
+			return true;
+		}
+#if defined(WIN32)||defined(_WIN32)
+		return FlushViewOfFile(base_, size_) != 0;
+#else
+		return msync(base_, size_, MS_ASYNC) == 0;
+#endif
+	}
+
+	inline bool mmap_output_type::sync() {
+		if (base_ == 0) {
+			return true;
+		}
+#if defined(WIN32)||defined(_WIN32)
+		return FlushViewOfFile(base_, size_) != 0;
+#else
+		return msync(base_, size_, MS_SYNC) == 0;
+#endif
+	}
+
+	inline bool mmap_output_type::pending() const {
+		return false;
+	}
+
+	inline int mmap_output_type::flush_interval() const {
+		return 0;
+	}
+
+	inline bool mmap_output_type::open(const char* name) {
+		if (base_ != 0) {
+			return true;
+		}
+		if (!map(name)) {
+			return false;
+		}
+		atomic_store(&ready_, 1);
+		return true;
+	}
+
+	inline void mmap_output_type::close() {
+		sync();
+	}
+
+	inline bool mmap_output_type::map(const char* name) {
+		unsigned long cap = 64*1024;
+		while (cap < cfg_.capacity) {
+			cap <<= 1;
+		}
+		size_t size = mmap_log_header::SIZE+cap;
+		mmap_log_header h;
+		memset(&h, 0, sizeof(h));
+#if defined(WIN32)||defined(_WIN32)
+		HANDLE file = CreateFileA(name, GENERIC_READ|GENERIC_WRITE, FILE_SHARE_READ|FILE_SHARE_WRITE, 0,
+								  OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		DWORD n = 0;
+		bool reuse = GetFileSize(file, 0) == size && ReadFile(file, &h, sizeof(h), &n, 0) && n == sizeof(h)
+					 && memcmp(h.magic, "WUYAMLOG", 8) == 0 && h.capacity == cap;
+		if (!reuse) {
+			// ضϺչȫ
+			SetFilePointer(file, 0, 0, FILE_BEGIN);
+			SetEndOfFile(file);
+			SetFilePointer(file, (LONG)size, 0, FILE_BEGIN);
+			SetEndOfFile(file);
+		}
+		HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READWRITE, 0, (DWORD)size, 0);
+		CloseHandle(file);
+		if (mapping == 0) {
+			return false;
+		}
+		void* p = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+		CloseHandle(mapping);
+		if (p == 0) {
+			return false;
+		}
+#else
+		int fd = ::open(name, O_RDWR|O_CREAT, 0644);
+		if (fd < 0) {
+			return false;
+		}
+		struct stat st;
+		bool reuse = fstat(fd, &st) == 0 && (size_t)st.st_size == size
+					 && pread(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h)
+					 && memcmp(h.magic, "WUYAMLOG", 8) == 0 && h.capacity == cap;
+		if (!reuse && (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0)) {
+			::close(fd);
+			return false;
+		}
+		int flags = MAP_SHARED;
+	#if defined(MAP_POPULATE)
+		// ԤȽҳд־ʱȱҳ
+		flags |= MAP_POPULATE;
+	#endif
+		void* p = mmap(0, size, PROT_READ|PROT_WRITE, flags, fd, 0);
+		::close(fd);
+		if (p == MAP_FAILED) {
+			return false;
+		}
+#endif
+		base_ = (char*)p;
+		size_ = size;
+		header_ = (mmap_log_header*)base_;
+		data_ = base_+mmap_log_header::SIZE;
+		mask_ = cap-1;
+		// ¼1/4
+		max_msg_ = cap/4-sizeof(mmap_log_record);
+		if (max_msg_ > 0xFFFF) {
+			max_msg_ = 0xFFFF;
+		}
+		if (!reuse) {
+			header_->version = mmap_log_header::VERSION;
+			header_->capacity = (unsigned int)cap;
+			header_->head = 0;
+			memcpy(header_->magic, "WUYAMLOG", 8);
+		}
+		return true;
+	}
+
+	inline bool output_traits<mmap_output_type>::write(mmap_output_type& op, const std::string& msg,
+													   LOGLEVEL level) {
+		return op.append(msg.data(), msg.size(), level);
+	}
+
+	inline bool output_traits<mmap_output_type>::write_direct(mmap_output_type& op, const char* msg, size_t len,
+															  LOGLEVEL level) {
+		return op.append(msg, len, level);
+	}
+
+	inline bool mmap_log_reader::entry::operator<(const entry& e) const {
+		return age > e.age;
+	}
+
+	inline mmap_log_reader::mmap_log_reader():next_(0) {
+	}
+
+	inline bool mmap_log_reader::open(const char* name) {
+		data_.clear();
+		entries_.clear();
+		next_ = 0;
+		std::ifstream in(name, std::ios::in|std::ios::binary);
+		mmap_log_header h;
+		if (!in.read((char*)&h, sizeof(h)) || memcmp(h.magic, "WUYAMLOG", 8) != 0
+			|| h.version != mmap_log_header::VERSION || h.capacity < 64 || (h.capacity & (h.capacity-1)) != 0) {
+			return false;
+		}
+		data_.resize(h.capacity);
+		if (!in.seekg(mmap_log_header::SIZE) || !in.read(&data_[0], h.capacity)) {
+			return false;
+		}
+		unsigned int head = (unsigned int)(unsigned long)h.head;
+		for (size_t off=0; off+sizeof(mmap_log_record)<=h.capacity; off+=8) {
+			const mmap_log_record* r = (const mmap_log_record*)&data_[off];
+			if (r->check != mmap_log_check(r->pos, r->size, r->level) || (r->pos & (h.capacity-1)) != off
+				|| off+sizeof(mmap_log_record)+r->size > h.capacity) {
+				continue;
+			}
+			// headһȦϵļ¼ѱָǣheadϴӳ
+			unsigned int age = head-r->pos;
+			if (age > h.capacity || age < sizeof(mmap_log_record)+r->size) {
+				continue;
+			}
+			entry e = {age, off};
+			entries_.push_back(e);
+		}
+		std::sort(entries_.begin(), entries_.end());
+		return true;
+	}
+
+	inline size_t mmap_log_reader::size() const {
+		return entries_.size();
+	}
+
+	inline bool mmap_log_reader::next(std::string& msg, LOGLEVEL& level) {
+		if (next_ >= entries_.size()) {
+			return false;
+		}
+		const mmap_log_record* r = (const mmap_log_record*)&data_[entries_[next_++].offset];
+		msg.assign((const char*)(r+1), r->size);
+		level = (LOGLEVEL)r->level;
+		return true;
+	}
+}
+
+#endif
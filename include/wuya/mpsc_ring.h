@@ -0,0 +1,168 @@
+#ifndef __WUYA_MPSC_RING_H__
+#define __WUYA_MPSC_RING_H__
+
+#include <wuya/atomic.h>
+
+namespace wuya{
+	/**
+	 * нζУλڹʱԤȷ䣬ߡһ
+	 * claim()ȡòλ͵дpublish()
+	 * peek()ȡòλrelease()黹
+	 * ͬCASƽڶʱҲȡɵԪء
+	 *
+	 * 㷨Dmitry Vyukovbounded MPMC queue
+	 *
+	 * @author wuya
+	 */
+	template<class T>
+	class mpsc_ring {
+	public:
+		/**
+		 * @param capacity ȡΪ2
+		 */
+		explicit mpsc_ring(unsigned long capacity);
+		~mpsc_ring();
+	public:
+		/**
+		 * ȡһвλ
+		 *
+		 * @param pos    زλţpublishʱ
+		 *
+		 * @return λʱ0
+		 */
+		T* claim(unsigned long& pos);
+		// claimõĲλ˺߿ɼ
+		void publish(unsigned long pos);
+		/**
+		 * ȡöײλ
+		 *
+		 * @param pos    زλţreleaseʱ
+		 *
+		 * @return λпʱ0
+		 */
+		T* peek(unsigned long& pos);
+		// 黹peekõĲλ
+		void release(unsigned long pos);
+		// ԪǷѷΪtrueʱpeek()ضɹʱ
+		bool readable() const;
+		// еԪظʱΪֵ
+		unsigned long size() const;
+		bool empty() const;
+		unsigned long capacity() const;
+		// ֱӷʲλڳʼ
+		T& slot(unsigned long i);
+	private:
+		struct cell {
+			volatile long seq;
+			T data;
+		};
+		// ߺߵλ÷ִͬ
+		char pad0_[64];
+		cell* cells_;
+		unsigned long mask_;
+		char pad1_[64];
+		volatile long tail_;
+		char pad2_[64];
+		volatile long head_;
+		char pad3_[64];
+	private:
+		mpsc_ring(const mpsc_ring& );
+		mpsc_ring& operator=(const mpsc_ring& );
+	};
+}
+
+//.............................ʵֲ.............................//
+namespace wuya{
+	template<class T>
+	inline mpsc_ring<T>::mpsc_ring(unsigned long capacity):tail_(0),head_(0) {
+		unsigned long size = 2;
+		while (size < capacity) {
+			size <<= 1;
+		}
+		mask_ = size-1;
+		cells_ = new cell[size];
+		for (unsigned long i=0; i<size; ++i) {
+			cells_[i].seq = (long)i;
+		}
+	}
+
+	template<class T>
+	inline mpsc_ring<T>::~mpsc_ring() {
+		delete [] cells_;
+	}
+
+	template<class T>
+	inline T* mpsc_ring<T>::claim(unsigned long& pos) {
+		unsigned long p = (unsigned long)atomic_load(&tail_);
+		while (true) {
+			cell& c = cells_[p & mask_];
+			long dif = (long)((unsigned long)atomic_load(&c.seq)-p);
+			if (dif == 0) {
+				if (atomic_cas(&tail_, (long)p, (long)(p+1))) {
+					pos = p;
+					return &c.data;
+				}
+			} else if (dif < 0) {
+				return 0;
+			}
+			p = (unsigned long)atomic_load(&tail_);
+		}
+	}
+
+	template<class T>
+	inline void mpsc_ring<T>::publish(unsigned long pos) {
+		atomic_store(&cells_[pos & mask_].seq, (long)(pos+1));
+	}
+
+	template<class T>
+	inline T* mpsc_ring<T>::peek(unsigned long& pos) {
+		unsigned long p = (unsigned long)atomic_load(&head_);
+		while (true) {
+			cell& c = cells_[p & mask_];
+			long dif = (long)((unsigned long)atomic_load(&c.seq)-(p+1));
+			if (dif == 0) {
+				if (atomic_cas(&head_, (long)p, (long)(p+1))) {
+					pos = p;
+					return &c.data;
+				}
+			} else if (dif < 0) {
+				return 0;
+			}
+			p = (unsigned long)atomic_load(&head_);
+		}
+	}
+
+	template<class T>
+	inline void mpsc_ring<T>::release(unsigned long pos) {
+		atomic_store(&cells_[pos & mask_].seq, (long)(pos+mask_+1));
+	}
+
+	template<class T>
+	inline bool mpsc_ring<T>::readable() const {
+		unsigned long p = (unsigned long)atomic_load(&head_);
+		return(unsigned long)atomic_load(&cells_[p & mask_].seq) == p+1;
+	}
+
+	template<class T>
+	inline unsigned long mpsc_ring<T>::size() const {
+		long n = (long)((unsigned long)atomic_load(&tail_)-(unsigned long)atomic_load(&head_));
+		return n<0?0:(unsigned long)n;
+	}
+
+	template<class T>
+	inline bool mpsc_ring<T>::empty() const {
+		return size() == 0;
+	}
+
+	template<class T>
+	inline unsigned long mpsc_ring<T>::capacity() const {
+		return mask_+1;
+	}
+
+	template<class T>
+	inline T& mpsc_ring<T>::slot(unsigned long i) {
+		return cells_[i & mask_].data;
+	}
+}
+
+#endif
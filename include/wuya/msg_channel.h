@@ -0,0 +1,295 @@
+#ifndef __WUYA_MSG_CHANNEL_H__
+#define __WUYA_MSG_CHANNEL_H__
+
+#include <cerrno>
+#include <cstring>
+#include <wuya/socket.h>
+#if !defined(WIN32)&&!defined(_WIN32)
+	#include <sys/uio.h>
+#endif
+
+namespace wuya{
+	/**
+	 * ϢͼֱָջеһϢ
+	 * һεmsg_channel::recv()֮ǰЧ
+	 */
+	struct msg_view {
+		const char* data;
+		int size;
+	};
+
+	/**
+	 * sock_streamĶϢͷ֡ͨ
+	 * ֡ʽ4ֽֽϢ峤 + Ϣ
+	 *
+	 * նһrecv֮ӻϢ
+	 * Ͷ˽ϢͷϲΪһwritev
+	 * sock_streamTṩrecv(void*, int)send(const void*, int)get_handler()
+	 *
+	 * @author wuya
+	 */
+	template <class sock_streamT>
+	class msg_channel {
+	public:
+		enum {
+			HEADER_SIZE = 4,
+			DEFAULT_BUFSIZE = 65536,
+			DEFAULT_MAX_MSG_SIZE = 16*1024*1024,
+			MAX_BATCH = 64
+		};
+		/**
+		 * @param sock         ӵsocket
+		 * @param bufsize      ջʼС
+		 * @param max_msg_size ϢȣΪЭ
+		 */
+		explicit msg_channel(sock_streamT& sock, int bufsize=DEFAULT_BUFSIZE,
+							 int max_msg_size=DEFAULT_MAX_MSG_SIZE);
+		~msg_channel();
+	public:
+		/**
+		 * һϢmsgָջ
+		 * Ϣʱϵͳ
+		 *
+		 * @return Ϣȣӹرջ-1
+		 */
+		int recv(msg_view& msg);
+		/**
+		 * һϢbuf
+		 *
+		 * @return Ϣȣbuf㷵-1
+		 */
+		int recv(void* buf, int n);
+		/**
+		 * ǷһϢʱrecv
+		 */
+		bool readable() const;
+		/**
+		 * Ϣ뷢Σ
+		 * bufָflush()֮ǰ뱣ЧʱԶflush
+		 *
+		 * @return ɹn-1
+		 */
+		int send(const void* buf, int n);
+		/**
+		 * ͵ǰеȫϢ
+		 *
+		 * @return ɹ0-1
+		 */
+		int flush();
+		/**
+		 * һϢflush
+		 */
+		int send_n(const void* buf, int n);
+		// ǰд͵Ϣ
+		int pending() const;
+	private:
+		bool reserve(int need);
+		int writev_all();
+	private:
+		msg_channel(const msg_channel& );
+		msg_channel& operator=(const msg_channel& );
+
+		sock_streamT& sock_;
+		char* inbuf_;
+		int bufsize_;
+		int max_msg_size_;
+		int rd_;
+		int wr_;
+
+#if defined(WIN32)||defined(_WIN32)
+		struct iovec {
+			void* iov_base;
+			size_t iov_len;
+		};
+#endif
+		unsigned char header_[MAX_BATCH][HEADER_SIZE];
+		iovec iov_[MAX_BATCH*2];
+		int iovcnt_;
+		int batch_;
+	};
+}
+
+//.............................ʵֲ.............................//
+namespace wuya{
+	inline void encode_msg_header(unsigned char* p, unsigned long n) {
+		p[0] = (unsigned char)(n>>24);
+		p[1] = (unsigned char)(n>>16);
+		p[2] = (unsigned char)(n>>8);
+		p[3] = (unsigned char)n;
+	}
+
+	inline unsigned long decode_msg_header(const char* buf) {
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(buf);
+		return((unsigned long)p[0]<<24)|((unsigned long)p[1]<<16)|((unsigned long)p[2]<<8)|p[3];
+	}
+
+	template <class sock_streamT>
+	inline msg_channel<sock_streamT>::msg_channel(sock_streamT& sock, int bufsize, int max_msg_size):
+	sock_(sock),bufsize_(bufsize<HEADER_SIZE?HEADER_SIZE:bufsize),max_msg_size_(max_msg_size),
+	rd_(0),wr_(0),iovcnt_(0),batch_(0) {
+		inbuf_ = new char[bufsize_];
+	}
+
+	template <class sock_streamT>
+	inline msg_channel<sock_streamT>::~msg_channel() {
+		flush();
+		delete [] inbuf_;
+	}
+
+	template <class sock_streamT>
+	inline bool msg_channel<sock_streamT>::readable() const {
+		int avail = wr_-rd_;
+		if (avail < HEADER_SIZE) {
+			return false;
+		}
+		return avail-HEADER_SIZE >= (int)decode_msg_header(inbuf_+rd_);
+	}
+
+	template <class sock_streamT>
+	inline bool msg_channel<sock_streamT>::reserve(int need) {
+		// βռ䲻ʱδƵͷҪʱ󻺳
+		if (bufsize_-rd_ >= need) {
+			return true;
+		}
+		int avail = wr_-rd_;
+		if (need > bufsize_) {
+			int size = bufsize_;
+			while (size < need) {
+				size *= 2;
+			}
+			char* buf = new char[size];
+			memcpy(buf, inbuf_+rd_, avail);
+			delete [] inbuf_;
+			inbuf_ = buf;
+			bufsize_ = size;
+		} else {
+			memmove(inbuf_, inbuf_+rd_, avail);
+		}
+		rd_ = 0;
+		wr_ = avail;
+		return true;
+	}
+
+	template <class sock_streamT>
+	inline int msg_channel<sock_streamT>::recv(msg_view& msg) {
+		while (true) {
+			int avail = wr_-rd_;
+			int need = HEADER_SIZE;
+			if (avail >= HEADER_SIZE) {
+				unsigned long len = decode_msg_header(inbuf_+rd_);
+				if (len > (unsigned long)max_msg_size_) {
+					return -1;
+				}
+				need += (int)len;
+				if (avail >= need) {
+					msg.data = inbuf_+rd_+HEADER_SIZE;
+					msg.size = (int)len;
+					rd_ += need;
+					return msg.size;
+				}
+			}
+			if (rd_ == wr_) {
+				rd_ = wr_ = 0;
+			}
+			reserve(need);
+			int n = sock_.recv(inbuf_+wr_, bufsize_-wr_);
+			if (n <= 0) {
+				return -1;
+			}
+			wr_ += n;
+		}
+	}
+
+	template <class sock_streamT>
+	inline int msg_channel<sock_streamT>::recv(void* buf, int n) {
+		msg_view msg;
+		if (recv(msg) < 0 || msg.size > n) {
+			return -1;
+		}
+		memcpy(buf, msg.data, msg.size);
+		return msg.size;
+	}
+
+	template <class sock_streamT>
+	inline int msg_channel<sock_streamT>::send(const void* buf, int n) {
+		if (n < 0 || n > max_msg_size_) {
+			return -1;
+		}
+		if (batch_ == MAX_BATCH && flush() != 0) {
+			return -1;
+		}
+		encode_msg_header(header_[batch_], (unsigned long)n);
+		iov_[iovcnt_].iov_base = header_[batch_];
+		iov_[iovcnt_].iov_len = HEADER_SIZE;
+		++iovcnt_;
+		if (n > 0) {
+			iov_[iovcnt_].iov_base = const_cast<void*>(buf);
+			iov_[iovcnt_].iov_len = n;
+			++iovcnt_;
+		}
+		++batch_;
+		return n;
+	}
+
+	template <class sock_streamT>
+	inline int msg_channel<sock_streamT>::send_n(const void* buf, int n) {
+		if (send(buf, n) < 0 || flush() != 0) {
+			return -1;
+		}
+		return n;
+	}
+
+	template <class sock_streamT>
+	inline int msg_channel<sock_streamT>::pending() const {
+		return batch_;
+	}
+
+	template <class sock_streamT>
+	inline int msg_channel<sock_streamT>::flush() {
+		if (batch_ == 0) {
+			return 0;
+		}
+		int ret = writev_all();
+		iovcnt_ = 0;
+		batch_ = 0;
+		return ret;
+	}
+
+	template <class sock_streamT>
+	inline int msg_channel<sock_streamT>::writev_all() {
+#if defined(WIN32)||defined(_WIN32)
+		for (int i=0; i<iovcnt_; ++i) {
+			int len = (int)iov_[i].iov_len;
+			if (sock_.send_n(iov_[i].iov_base, len) != len) {
+				return -1;
+			}
+		}
+		return 0;
+#else
+		iovec* iov = iov_;
+		int cnt = iovcnt_;
+		while (cnt > 0) {
+			ssize_t n = ::writev(sock_.get_handler(), iov, cnt);
+			if (n < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return -1;
+			}
+			// дʱѷ͵Ĳּ
+			while (cnt > 0 && (size_t)n >= iov->iov_len) {
+				n -= iov->iov_len;
+				++iov;
+				--cnt;
+			}
+			if (cnt > 0) {
+				iov->iov_base = (char*)iov->iov_base+n;
+				iov->iov_len -= n;
+			}
+		}
+		return 0;
+#endif
+	}
+}
+
+#endif
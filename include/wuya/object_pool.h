@@ -4,6 +4,8 @@
 #include <string>
 #include <cstdlib>
 #include <wuya/ipc.h>
+#include <wuya/trace.h>
+#include <wuya/histogram.h>
 
 namespace wuya {
 	/**
@@ -41,6 +43,10 @@ namespace wuya {
 		T& get_object();
 		void revert_object(T& obj);
 		void close_object(T& obj);
+		/**
+		 * get_objectĵȴʱ䣨룩ȴʱΪ0
+		 */
+		const histogram<>& wait_time() const;
 	protected:
 		T* objs_;
 		int* ids_;
@@ -56,6 +62,7 @@ namespace wuya {
 	private:
 		MUTEX_TYPE mutex_;
 		CONDITION_TYPE condition_;
+		histogram<> wait_time_;
 	private:
 		pool_t(MUTEX_TYPE* m);
 		pool_t(const pool_t& src);
@@ -186,15 +193,25 @@ namespace wuya {
 		mutex_guard<M> guard(mutex_);
 		guard;
 		if( available_ != 0 ) {
+			wait_time_.record(0);
 			return get_object_i();
 		} else {
+			WUYA_TRACE_SCOPE_CAT("pool", "object_pool wait");
+			mono_timer t(true);
 			while( available_ == 0 ) {
 				condition_.wait();
 			}
+			// ڼ¼ͬһʱֻһ߳д
+			wait_time_.record(t.elapsed_ns());
 			return get_object_i();
 		}
 	}
 
+	template <class T, class P, class M, class C>
+	inline const histogram<>& pool_t<T,P,M,C>::wait_time() const {
+		return wait_time_;
+	}
+
 	template <class T, class P, class M, class C>
 	inline int pool_t<T,P,M,C>::get_id(T& obj) {
 		if( &obj-objs_<0 ) {
@@ -1,6 +1,9 @@
 #ifndef __WUYA_SOCKET_H__
 #define __WUYA_SOCKET_H__
 
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #if defined(WIN32)||defined(_WIN32)
 	#include <winsock2.h>
 typedef SOCKET socket_type;
@@ -10,10 +13,14 @@ typedef SOCKET socket_type;
 	#include <sys/socket.h>
 	#include <netinet/in.h>
 	#include <arpa/inet.h>
+	#include <sys/un.h>
+	#include <sys/uio.h>
+	#include <unistd.h>
 	#define INVALID_SOCKET -1
 	#define SOCKET_ERROR -1
 typedef int socket_type;
 #endif
+#include <wuya/trace.h>
 namespace wuya{
 	bool sock_init();
 	void sock_fini();
@@ -39,6 +46,31 @@ namespace wuya{
 		sockaddr_in  inet_addr_;
 	};
 
+#if !defined(WIN32)&&!defined(_WIN32)
+	/**
+	 * ׽ֵַAF_UNIX
+	 * ·'@'ͷʱʹLinuxռ䣬ļϵͳдļ
+	 */
+	class unix_addr {
+	public:
+		unix_addr();
+		explicit unix_addr(const char path[]);
+
+		int set(const char path[]);
+
+		const char *get_path() const;
+		void * get_addr() const;
+		// ַЧȣbind/connect
+		int get_size() const;
+		// ǷΪռַ
+		bool is_abstract() const;
+	protected:
+		void reset();
+		sockaddr_un  unix_addr_;
+		int size_;
+	};
+#endif
+
 	class sock_stream {
 	public:
 		int recv(void *buf, int n);
@@ -51,15 +83,45 @@ namespace wuya{
 		int get_remote_addr (ip_addr& addr) const;
 		socket_type get_handler();
 		void set_handler(socket_type h);
+#if !defined(WIN32)&&!defined(_WIN32)
+	public:
+		/**
+		 * AF_UNIXӰһѴ򿪵ľԶˣSCM_RIGHTS
+		 * ͺ󱾶˾ȻЧйر
+		 *
+		 * @return ɹ0ʧܷ-1
+		 */
+		int send_handle(socket_type h);
+		/**
+		 * նԶ˾send_handleľ
+		 * ԶһδϢضʱرյľʧ
+		 *
+		 * @return ɹ0ʧܷ-1
+		 */
+		int recv_handle(socket_type& h);
+#endif
 	protected:
 		socket_type sock_;
 	};
 
+#if !defined(WIN32)&&!defined(_WIN32)
+	/**
+	 * һԻӵAF_UNIX׽
+	 *
+	 * @return ɹ0ʧܷ-1
+	 */
+	int sock_pair(sock_stream& s1, sock_stream& s2);
+#endif
+
 	class sock_connector {
 	public:
 		sock_connector();
 		sock_connector(sock_stream &new_stream, const ip_addr &remote_sap);
 		int connect(sock_stream &new_stream, const ip_addr &remote_sap);
+#if !defined(WIN32)&&!defined(_WIN32)
+		sock_connector(sock_stream &new_stream, const unix_addr &remote_sap);
+		int connect(sock_stream &new_stream, const unix_addr &remote_sap);
+#endif
 	};
 
 	class sock_acceptor {
@@ -67,6 +129,11 @@ namespace wuya{
 		sock_acceptor();
 		sock_acceptor(const ip_addr &local_sap, int reuse_addr=0);
 		int open (const ip_addr &local_sap, int reuse_addr=0);
+#if !defined(WIN32)&&!defined(_WIN32)
+		// unlink_pathΪtrueʱɾѴڵ׽ļϴδ˳ʱµģ
+		sock_acceptor(const unix_addr &local_sap, bool unlink_path=false);
+		int open (const unix_addr &local_sap, bool unlink_path=false);
+#endif
 		int accept (sock_stream &new_stream);
 	protected:
 		socket_type sock_;
@@ -164,6 +231,49 @@ namespace wuya{
 		return 0;
 	}
 
+#if !defined(WIN32)&&!defined(_WIN32)
+	inline unix_addr::unix_addr() {
+		reset();
+	}
+	inline unix_addr::unix_addr(const char path[]) {
+		reset();
+		set(path);
+	}
+	inline void unix_addr::reset() {
+		memset (&this->unix_addr_, 0, sizeof (this->unix_addr_));
+		this->unix_addr_.sun_family = AF_UNIX;
+		size_ = (int)sizeof(sa_family_t);
+	}
+	inline int unix_addr::set(const char path[]) {
+		if (path == 0) {
+			return -1;
+		}
+		size_t len = strlen(path);
+		if (len >= sizeof(unix_addr_.sun_path)) {
+			return -1;
+		}
+		reset();
+		memcpy(unix_addr_.sun_path, path, len);
+		if (path[0] == '@') {
+			unix_addr_.sun_path[0] = '\0';
+		}
+		size_ = (int)(offsetof(sockaddr_un, sun_path)+len+(path[0]=='@'?0:1));
+		return 0;
+	}
+	inline const char *unix_addr::get_path() const {
+		return is_abstract()?unix_addr_.sun_path+1:unix_addr_.sun_path;
+	}
+	inline void *unix_addr::get_addr() const {
+		return(void*)&unix_addr_;
+	}
+	inline int unix_addr::get_size() const {
+		return size_;
+	}
+	inline bool unix_addr::is_abstract() const {
+		return size_ > (int)offsetof(sockaddr_un, sun_path) && unix_addr_.sun_path[0] == '\0';
+	}
+#endif
+
 	inline unsigned short ip_addr::get_port_number() const {
 		return ntohs (this->inet_addr_.sin_port);
 	}
@@ -175,12 +285,15 @@ namespace wuya{
 	}
 
 	inline int sock_stream::recv(void *buf, int n) {
+		WUYA_TRACE_SCOPE_CAT("socket", "recv");
 		return ::recv(sock_, (char*)buf, n, 0);
 	}
 	inline int sock_stream::send(const void *buf, int n) {
+		WUYA_TRACE_SCOPE_CAT("socket", "send");
 		return ::send(sock_, (const char*)buf, n, 0);
 	}
 	inline int sock_stream::recv_n(void *buf, int n) {
+		WUYA_TRACE_SCOPE_CAT("socket", "recv_n");
 		int left = n;
 		int n_read;
 		while (left !=0 && (n_read = ::recv(sock_, (char*)buf+(n-left), left, 0)) != SOCKET_ERROR) {
@@ -189,6 +302,7 @@ namespace wuya{
 		return n - left;
 	}
 	inline int sock_stream::send_n(const void *buf, int n) {
+		WUYA_TRACE_SCOPE_CAT("socket", "send_n");
 		int left = n;
 		int n_read;
 		while (left !=0 && (n_read = ::send(sock_, (char*)buf+(n-left), left, 0)) != SOCKET_ERROR) {
@@ -240,6 +354,81 @@ namespace wuya{
 		sock_ = h;
 	}
 
+#if !defined(WIN32)&&!defined(_WIN32)
+	inline int sock_stream::send_handle(socket_type h) {
+		char dummy = 0;
+		iovec iov;
+		iov.iov_base = &dummy;
+		iov.iov_len = 1;
+		union {
+			cmsghdr hdr;
+			char buf[CMSG_SPACE(sizeof(int))];
+		} ctrl;
+		memset(&ctrl, 0, sizeof ctrl);
+		msghdr msg;
+		memset(&msg, 0, sizeof msg);
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = ctrl.buf;
+		msg.msg_controllen = sizeof(ctrl.buf);
+		cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+		memcpy(CMSG_DATA(cmsg), &h, sizeof(int));
+		if (::sendmsg(sock_, &msg, 0) != 1) {
+			return -1;
+		}
+		return 0;
+	}
+	inline int sock_stream::recv_handle(socket_type& h) {
+		char dummy;
+		iovec iov;
+		iov.iov_base = &dummy;
+		iov.iov_len = 1;
+		union {
+			cmsghdr hdr;
+			char buf[CMSG_SPACE(sizeof(int))];
+		} ctrl;
+		msghdr msg;
+		memset(&msg, 0, sizeof msg);
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = ctrl.buf;
+		msg.msg_controllen = sizeof(ctrl.buf);
+		if (::recvmsg(sock_, &msg, 0) != 1) {
+			return -1;
+		}
+		cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+		if (cmsg == 0 || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS
+			|| cmsg->cmsg_len < CMSG_LEN(sizeof(int))) {
+			return -1;
+		}
+		// ɲֹһĺͽضʱյĶҪرգй©
+		size_t n = (cmsg->cmsg_len-CMSG_LEN(0))/sizeof(int);
+		if (n != 1 || (msg.msg_flags & MSG_CTRUNC)) {
+			for (size_t i=0; i<n; ++i) {
+				int fd;
+				memcpy(&fd, CMSG_DATA(cmsg)+i*sizeof(int), sizeof(int));
+				::close(fd);
+			}
+			return -1;
+		}
+		memcpy(&h, CMSG_DATA(cmsg), sizeof(int));
+		return 0;
+	}
+
+	inline int sock_pair(sock_stream& s1, sock_stream& s2) {
+		socket_type sv[2];
+		if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == SOCKET_ERROR) {
+			return -1;
+		}
+		s1.set_handler(sv[0]);
+		s2.set_handler(sv[1]);
+		return 0;
+	}
+#endif
+
 	inline sock_connector::sock_connector() {
 
 	}
@@ -247,6 +436,7 @@ namespace wuya{
 		connect(new_stream, remote_sap);
 	}
 	inline int sock_connector::connect(sock_stream &new_stream, const ip_addr &remote_sap) {
+		WUYA_TRACE_SCOPE_CAT("socket", "connect");
 		socket_type sock = ::socket(AF_INET, SOCK_STREAM, 0);
 		if (sock == INVALID_SOCKET) {
 			return -1;
@@ -258,14 +448,32 @@ namespace wuya{
 		return 0;
 	}
 
-	inline sock_acceptor::sock_acceptor() {
+#if !defined(WIN32)&&!defined(_WIN32)
+	inline sock_connector::sock_connector(sock_stream &new_stream, const unix_addr &remote_sap) {
+		connect(new_stream, remote_sap);
+	}
+	inline int sock_connector::connect(sock_stream &new_stream, const unix_addr &remote_sap) {
+		WUYA_TRACE_SCOPE_CAT("socket", "connect");
+		socket_type sock = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (sock == INVALID_SOCKET) {
+			return -1;
+		}
+		new_stream.set_handler(sock);
+		if (::connect(sock, (sockaddr*)remote_sap.get_addr(), remote_sap.get_size()) == SOCKET_ERROR) {
+			return -1;
+		}
+		return 0;
+	}
+#endif
+
+	inline sock_acceptor::sock_acceptor():sock_(INVALID_SOCKET) {
 	}
-	inline sock_acceptor::sock_acceptor(const ip_addr &local_sap, int reuse_addr) {
+	inline sock_acceptor::sock_acceptor(const ip_addr &local_sap, int reuse_addr):sock_(INVALID_SOCKET) {
 		open(local_sap, reuse_addr);
 	}
 	inline int sock_acceptor::open (const ip_addr &local_sap, int reuse_addr) {
 		socket_type sock = ::socket(AF_INET, SOCK_STREAM, 0);
-		if (sock_ == INVALID_SOCKET) {
+		if (sock == INVALID_SOCKET) {
 			return -1;
 		}
 		sock_ = sock;
@@ -281,8 +489,30 @@ namespace wuya{
 		}
 		return 0;
 	}
+#if !defined(WIN32)&&!defined(_WIN32)
+	inline sock_acceptor::sock_acceptor(const unix_addr &local_sap, bool unlink_path):sock_(INVALID_SOCKET) {
+		open(local_sap, unlink_path);
+	}
+	inline int sock_acceptor::open (const unix_addr &local_sap, bool unlink_path) {
+		socket_type sock = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (sock == INVALID_SOCKET) {
+			return -1;
+		}
+		sock_ = sock;
+		if (unlink_path && !local_sap.is_abstract()) {
+			::unlink(local_sap.get_path());
+		}
+		if (bind (sock_, (sockaddr*)local_sap.get_addr(), local_sap.get_size()) == SOCKET_ERROR) {
+			return -1;
+		}
+		if (listen(sock_, 100) == SOCKET_ERROR) {
+			return -1;
+		}
+		return 0;
+	}
+#endif
 	inline int sock_acceptor::accept (sock_stream &new_stream) {
-		sockaddr_in from;
+		sockaddr_storage from;
 #ifdef SOCKLEN_T
 		socklen_t len;
 #else
@@ -291,6 +521,7 @@ namespace wuya{
 		len = sizeof(from);
 		memset(&from, 0, len);
 
+		WUYA_TRACE_SCOPE_CAT("socket", "accept");
 		socket_type newsocket = ::accept(sock_, (sockaddr*)&from, &len);
 		if (newsocket == INVALID_SOCKET) {
 			return -1;
@@ -81,9 +81,9 @@ namespace wuya{
 
 	template <class sock_streamT, class charT, class traits>
 	std::basic_streambuf<charT, traits>* socketstreambuf<sock_streamT, charT, traits>::setbuf (char_type *s, std::streamsize n) {
-		if (gptr() == 0) {
-			setg (s, s + n, s + n);
-			setp (s, s + n);
+		if (this->gptr() == 0) {
+			this->setg (s, s + n, s + n);
+			this->setp (s, s + n);
 			inbuf_ = s;
 			outbuf_ = s;
 			bufsize_ = n;
@@ -94,7 +94,7 @@ namespace wuya{
 
 	template <class sock_streamT, class charT, class traits>
 	void socketstreambuf<sock_streamT, charT, traits>::_flush() {
-		rsocket_.send(outbuf_, (int)(pptr() - outbuf_) * sizeof(char_type));
+		rsocket_.send(outbuf_, (int)(this->pptr() - outbuf_) * sizeof(char_type));
 	}
 
 	template <class sock_streamT, class charT, class traits>
@@ -105,16 +105,16 @@ namespace wuya{
 
 		// if the buffer was not already allocated nor set by user,
 		// do it just now
-		if (pptr() == 0) {
+		if (this->pptr() == 0) {
 			outbuf_ = new char_type[bufsize_];
 			ownbuffers_ = true;
 		} else {
 			_flush();
 		}
 
-		setp(outbuf_, outbuf_ + bufsize_);
+		this->setp(outbuf_, outbuf_ + bufsize_);
 		if (c != traits::eof()) {
-			sputc(traits::to_char_type(c));
+			this->sputc(traits::to_char_type(c));
 		}
 		return 0;
 	}
@@ -123,7 +123,7 @@ namespace wuya{
 	int socketstreambuf<sock_streamT, charT, traits>::sync() {
 		// just flush the put area
 		_flush();
-		setp (outbuf_, outbuf_ + bufsize_);
+		this->setp (outbuf_, outbuf_ + bufsize_);
 		return 0;
 	}
 
@@ -134,7 +134,7 @@ namespace wuya{
 
 		// if the buffer was not already allocated nor set by user,
 		// do it just now
-		if (gptr() == 0) {
+		if (this->gptr() == 0) {
 			inbuf_ = new char_type[bufsize_];
 			ownbuffers_ = true;
 		}
@@ -154,13 +154,13 @@ namespace wuya{
 		if (readn == 0)	 return traits::eof();
 
 		size_t totalbytes = readn + remained_;
-		setg (inbuf_, inbuf_, inbuf_ + totalbytes / sizeof(char_type));
+		this->setg (inbuf_, inbuf_, inbuf_ + totalbytes / sizeof(char_type));
 
 		remained_ = totalbytes % sizeof(char_type);
 		if (remained_ != 0) {
 			remainedchar_ = inbuf_[totalbytes / sizeof(char_type)];
 		}
-		return sgetc();
+		return this->sgetc();
 	}
 
 	template <class sock_streamT, class charT, class traits>
@@ -0,0 +1,148 @@
+#ifndef __WUYA_SPSC_RING_H__
+#define __WUYA_SPSC_RING_H__
+
+#include <wuya/atomic.h>
+
+namespace wuya{
+	/**
+	 * нζУλڹʱԤȷ䣬ֻһߡһ
+	 * ӿmpsc_ringͬ˫ԻԷλãֻڿʱŶȡԷĻС
+	 *
+	 * @author wuya
+	 */
+	template<class T>
+	class spsc_ring {
+	public:
+		/**
+		 * @param capacity ȡΪ2
+		 */
+		explicit spsc_ring(unsigned long capacity);
+		~spsc_ring();
+	public:
+		/**
+		 * ȡһвλ
+		 *
+		 * @param pos    زλţpublishʱ
+		 *
+		 * @return λʱ0
+		 */
+		T* claim(unsigned long& pos);
+		// claimõĲλ˺߿ɼ
+		void publish(unsigned long pos);
+		/**
+		 * ȡöײλ
+		 *
+		 * @param pos    زλţreleaseʱ
+		 *
+		 * @return λпʱ0
+		 */
+		T* peek(unsigned long& pos);
+		// 黹peekõĲλ
+		void release(unsigned long pos);
+		bool readable() const;
+		// еԪظʱΪֵ
+		unsigned long size() const;
+		bool empty() const;
+		unsigned long capacity() const;
+		// ֱӷʲλڳʼ
+		T& slot(unsigned long i);
+	private:
+		char pad0_[64];
+		T* cells_;
+		unsigned long mask_;
+		char pad1_[64];
+		// ߵλü仺λ
+		volatile long tail_;
+		unsigned long head_cache_;
+		char pad2_[64];
+		// ߵλü仺λ
+		volatile long head_;
+		unsigned long tail_cache_;
+		char pad3_[64];
+	private:
+		spsc_ring(const spsc_ring& );
+		spsc_ring& operator=(const spsc_ring& );
+	};
+}
+
+//.............................ʵֲ.............................//
+namespace wuya{
+	template<class T>
+	inline spsc_ring<T>::spsc_ring(unsigned long capacity):tail_(0),head_cache_(0),head_(0),tail_cache_(0) {
+		unsigned long size = 2;
+		while (size < capacity) {
+			size <<= 1;
+		}
+		mask_ = size-1;
+		cells_ = new T[size];
+	}
+
+	template<class T>
+	inline spsc_ring<T>::~spsc_ring() {
+		delete [] cells_;
+	}
+
+	template<class T>
+	inline T* spsc_ring<T>::claim(unsigned long& pos) {
+		unsigned long p = (unsigned long)tail_;
+		if (p-head_cache_ > mask_) {
+			head_cache_ = (unsigned long)atomic_load(&head_);
+			if (p-head_cache_ > mask_) {
+				return 0;
+			}
+		}
+		pos = p;
+		return &cells_[p & mask_];
+	}
+
+	template<class T>
+	inline void spsc_ring<T>::publish(unsigned long pos) {
+		atomic_store(&tail_, (long)(pos+1));
+	}
+
+	template<class T>
+	inline T* spsc_ring<T>::peek(unsigned long& pos) {
+		unsigned long p = (unsigned long)head_;
+		if (p == tail_cache_) {
+			tail_cache_ = (unsigned long)atomic_load(&tail_);
+			if (p == tail_cache_) {
+				return 0;
+			}
+		}
+		pos = p;
+		return &cells_[p & mask_];
+	}
+
+	template<class T>
+	inline void spsc_ring<T>::release(unsigned long pos) {
+		atomic_store(&head_, (long)(pos+1));
+	}
+
+	template<class T>
+	inline bool spsc_ring<T>::readable() const {
+		return atomic_load(&tail_) != atomic_load(&head_);
+	}
+
+	template<class T>
+	inline unsigned long spsc_ring<T>::size() const {
+		long n = (long)((unsigned long)atomic_load(&tail_)-(unsigned long)atomic_load(&head_));
+		return n<0?0:(unsigned long)n;
+	}
+
+	template<class T>
+	inline bool spsc_ring<T>::empty() const {
+		return size() == 0;
+	}
+
+	template<class T>
+	inline unsigned long spsc_ring<T>::capacity() const {
+		return mask_+1;
+	}
+
+	template<class T>
+	inline T& spsc_ring<T>::slot(unsigned long i) {
+		return cells_[i & mask_];
+	}
+}
+
+#endif
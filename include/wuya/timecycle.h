@@ -313,8 +313,9 @@ namespace wuya{
 	inline datetime at_time_cycle_policy::do_month(const datetime& begin_time,
 												   bool inc_begin_time) const {
 		int real_day = every_;
-		int year = begin_time.year();
-		int month = begin_time.month();
+		datetime_fields bf = begin_time.fields();
+		int year = bf.year;
+		int month = bf.month;
 		if (every_ < 0) {
 			int d = 1;
 			int y = year;
@@ -330,9 +331,8 @@ namespace wuya{
 			real_day = tmp.day();
 		}
 		datetime next;
-		if (real_day == begin_time.day()) {
-			next.set(year, month, real_day, begin_time.hour(), begin_time.minute(),
-					 begin_time.second());
+		if (real_day == bf.day) {
+			next.set(year, month, real_day, bf.hour, bf.minute, bf.second);
 		} else {
 			next.set(year, month, real_day);
 		}
@@ -407,7 +407,8 @@ namespace wuya{
 					next_time = begin_time + timespan(next_day-week_day, 0);
 					return next_time;
 				} else {
-					next_time.set(begin_time.year(), begin_time.month(), begin_time.day());
+					datetime_fields bf = begin_time.fields();
+					next_time.set(bf.year, bf.month, bf.day);
 					next_time = next_time + timespan(next_day-week_day, 0);
 					merge_day_time(next_time, start_time_, next_time);
 					return next_time;
@@ -422,9 +423,9 @@ namespace wuya{
 		if (days_ == 0) {
 			return datetime(-1);
 		}
-		int year = begin_time.year();
-		int month = begin_time.month();
-		int day = begin_time.day();
+		datetime_fields bf = begin_time.fields();
+		int year = bf.year;
+		int month = bf.month;
 		int sw_day = 1;
 		for (int i=0; i<7; ++i) {
 			if (days_>>i == 1) {
@@ -434,8 +435,7 @@ namespace wuya{
 		}
 		datetime first_day;
 		if (every_>0) {
-			first_day.set(year, month, 1, begin_time.hour(), begin_time.minute(),
-						  begin_time.second());
+			first_day.set(year, month, 1, bf.hour, bf.minute, bf.second);
 			int w_day = first_day.get_day_of_week();
 			int defer = sw_day-w_day;
 			if (defer < 0) {
@@ -453,12 +453,10 @@ namespace wuya{
 			} else {
 				++m;
 			}
-			first_day.set(y, m, 1, begin_time.hour(), begin_time.minute(),
-						  begin_time.second());
-			first_day = first_day - timespan(0,begin_time.hour(), begin_time.minute(),
-											 begin_time.second()+1);
-			first_day.set(first_day.year(), first_day.month(), first_day.day(),
-						  begin_time.hour(), begin_time.minute(),begin_time.second());
+			first_day.set(y, m, 1, bf.hour, bf.minute, bf.second);
+			first_day = first_day - timespan(0, bf.hour, bf.minute, bf.second+1);
+			datetime_fields ff = first_day.fields();
+			first_day.set(ff.year, ff.month, ff.day, bf.hour, bf.minute, bf.second);
 			int w_day = first_day.get_day_of_week();
 			int defer = sw_day-w_day;
 			if (defer > 0) {
@@ -473,10 +471,11 @@ namespace wuya{
 			if (day_policy_ == NO_CYCLE) {
 				return first_day;
 			} else {
-				return datetime(first_day.year(), first_day.month(), first_day.day());
+				datetime_fields ff = first_day.fields();
+				return datetime(ff.year, ff.month, ff.day);
 			}
 		}
-		if (day_policy_ == CYCLE && begin_time.day()==first_day.day()) {
+		if (day_policy_ == CYCLE && bf.day==first_day.day()) {
 			datetime next;
 			datetime start;
 			datetime end;
@@ -491,8 +490,7 @@ namespace wuya{
 		} else {
 			++month;
 		}
-		return do_month_week(datetime(year, month, 1, begin_time.hour(), begin_time.minute(),
-									  begin_time.second()), inc_begin_time);
+		return do_month_week(datetime(year, month, 1, bf.hour, bf.minute, bf.second), inc_begin_time);
 	}
 
 	inline datetime at_time_cycle_policy::do_day(const datetime& begin_time,
@@ -515,14 +513,15 @@ namespace wuya{
 
 	inline void at_time_cycle_policy::merge_day_time(const datetime& date0, const datetime& time0,
 													 datetime& result) const {
-		result.set(date0.year(), date0.month(), date0.day(), time0.hour(), time0.minute(),
-				   time0.second());
+		datetime_fields d = date0.fields();
+		datetime_fields t = time0.fields();
+		result.set(d.year, d.month, d.day, t.hour, t.minute, t.second);
 	}
 
 	inline void at_time_cycle_policy::init() {
-		datetime now = datetime::current_time();
-		start_time_.set(now.year(), now.month(), now.day());
-		end_time_.set(now.year(), now.month(), now.day(), 23, 59, 59);
+		datetime_fields now = datetime::current_time().fields();
+		start_time_.set(now.year, now.month, now.day);
+		end_time_.set(now.year, now.month, now.day, 23, 59, 59);
 		days_ &= 0x7f;
 		// ֻһЧ
 		if (unit_==MONTH_WEEK) {
@@ -4,9 +4,18 @@
 #include <time.h>
 #if defined(WIN32) || defined(_WIN32)
 	#include <sys/timeb.h>
+	#define _WINSOCKAPI_
+	#include <windows.h>
 #else
 	#include <sys/time.h>
 #endif
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	#include <intrin.h>
+	#define WUYA_HAS_RDTSC
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	#include <x86intrin.h>
+	#define WUYA_HAS_RDTSC
+#endif
 
 namespace wuya{
 /**
@@ -126,6 +135,232 @@ namespace wuya{
 	protected:
 		clock_t start_;
 	};
+
+	/**
+	 * ʱӼʱϵͳʱӰ죬Ϊ
+	 * LinuxΪCLOCK_MONOTONICWindowsΪQueryPerformanceCounter
+	 *
+	 * @author wuya
+	 */
+	class mono_timer {
+	public:
+		/**
+		 * ʼһʵѡǷʼʱ
+		 *
+		 * @param start  Ƿʼʱ
+		 */
+		mono_timer(bool autostart=false):start_(0) {
+			if (autostart == true) {
+				start();
+			}
+		}
+		/**
+		 * ʼʱ
+		 */
+		void start() {
+			start_ = now_ns();
+		}
+		/**
+		 * ֹʱ
+		 *
+		 * @return ʱʱ룩
+		 */
+		double end() {
+			return static_cast<double>(elapsed_ns())/1e9;
+		}
+		/**
+		 * ӿʼʱ
+		 */
+		long long elapsed_ns() const {
+			return now_ns()-start_;
+		}
+		/**
+		 * ʱӵĵǰֵ룩㲻ȷֻ
+		 */
+		static long long now_ns() {
+#if defined(WIN32) || defined(_WIN32)
+			static LARGE_INTEGER freq = {{0, 0}};
+			if (freq.QuadPart == 0) {
+				QueryPerformanceFrequency(&freq);
+			}
+			LARGE_INTEGER t;
+			QueryPerformanceCounter(&t);
+			// ȷֳ룬˷
+			long long sec = t.QuadPart/freq.QuadPart;
+			long long rem = t.QuadPart%freq.QuadPart;
+			return sec*1000000000+rem*1000000000/freq.QuadPart;
+#else
+			timespec ts;
+			clock_gettime(CLOCK_MONOTONIC, &ts);
+			return static_cast<long long>(ts.tv_sec)*1000000000+ts.tv_nsec;
+#endif
+		}
+	protected:
+		long long start_;
+	};
+
+	/**
+	 * CPUʱrdtsc/rdtscpʱ΢뼶ĲԼʮ
+	 * ״ʹʱյʱУ׼ƵʣԼ10룩ҪCPUTSC㶨Ƶʣinvariant TSC
+	 * ִx86㣻x86ƽ̨˻Ϊmono_timer
+	 *
+	 * @author wuya
+	 */
+	class cycle_timer {
+	public:
+		/**
+		 * ʼһʵѡǷʼʱ
+		 *
+		 * @param start  Ƿʼʱ
+		 */
+		cycle_timer(bool autostart=false):start_(0) {
+			if (autostart == true) {
+				start();
+			}
+		}
+		/**
+		 * ʼʱ֮ǰִָŶ
+		 */
+		void start() {
+			start_ = begin_cycles();
+		}
+		/**
+		 * ֹʱ
+		 *
+		 * @return ʱʱ룩
+		 */
+		double end() {
+			return static_cast<double>(elapsed_cycles())/cycles_per_ns()/1e9;
+		}
+		/**
+		 * ӿʼʱ
+		 */
+		long long elapsed_cycles() const {
+			return end_cycles()-start_;
+		}
+		/**
+		 * ӿʼʱ
+		 */
+		double elapsed_ns() const {
+			return static_cast<double>(elapsed_cycles())/cycles_per_ns();
+		}
+		/**
+		 * ȴ֮ǰָС
+		 */
+		static long long cycles() {
+#if defined(WUYA_HAS_RDTSC)
+			return static_cast<long long>(__rdtsc());
+#else
+			return mono_timer::now_ns();
+#endif
+		}
+		/**
+		 * ÿ״εʱУ׼
+		 */
+		static double cycles_per_ns() {
+			static double rate = calibrate();
+			return rate;
+		}
+	protected:
+		static long long begin_cycles() {
+#if defined(WUYA_HAS_RDTSC)
+			_mm_lfence();
+			return static_cast<long long>(__rdtsc());
+#else
+			return mono_timer::now_ns();
+#endif
+		}
+		static long long end_cycles() {
+#if defined(WUYA_HAS_RDTSC)
+			// rdtscpȴ֮ǰָɣlfenceָֹ֮ǰִ
+			unsigned int aux;
+			long long c = static_cast<long long>(__rdtscp(&aux));
+			_mm_lfence();
+			return c;
+#else
+			return mono_timer::now_ns();
+#endif
+		}
+		static double calibrate() {
+#if defined(WUYA_HAS_RDTSC)
+			long long t0 = mono_timer::now_ns();
+			long long c0 = begin_cycles();
+			long long t1;
+			do {
+				t1 = mono_timer::now_ns();
+			} while (t1-t0 < 10000000);
+			long long c1 = end_cycles();
+			return static_cast<double>(c1-c0)/static_cast<double>(t1-t0);
+#else
+			return 1.0;
+#endif
+		}
+
+		long long start_;
+	};
+
+	/**
+	 * ߳ռõCPUʱʱȴ̵߳ʱ
+	 * LinuxΪCLOCK_THREAD_CPUTIME_IDWindowsΪGetThreadTimesԼΪʱƬ
+	 *
+	 * @author wuya
+	 */
+	class thread_cpu_timer {
+	public:
+		/**
+		 * ʼһʵѡǷʼʱ
+		 *
+		 * @param start  Ƿʼʱ
+		 */
+		thread_cpu_timer(bool autostart=false):start_(0) {
+			if (autostart == true) {
+				start();
+			}
+		}
+		/**
+		 * ʼʱ
+		 */
+		void start() {
+			start_ = now_ns();
+		}
+		/**
+		 * ֹʱ
+		 *
+		 * @return ʱʱ룩
+		 */
+		double end() {
+			return static_cast<double>(elapsed_ns())/1e9;
+		}
+		/**
+		 * ӿʼʱ߳ռõCPU
+		 */
+		long long elapsed_ns() const {
+			return now_ns()-start_;
+		}
+		/**
+		 * ߳ռõCPUʱ䣨룩û̬ں̬
+		 */
+		static long long now_ns() {
+#if defined(WIN32) || defined(_WIN32)
+			FILETIME create_time, exit_time, kernel_time, user_time;
+			if (!GetThreadTimes(GetCurrentThread(), &create_time, &exit_time, &kernel_time, &user_time)) {
+				return 0;
+			}
+			ULARGE_INTEGER k, u;
+			k.LowPart = kernel_time.dwLowDateTime;
+			k.HighPart = kernel_time.dwHighDateTime;
+			u.LowPart = user_time.dwLowDateTime;
+			u.HighPart = user_time.dwHighDateTime;
+			return static_cast<long long>(k.QuadPart+u.QuadPart)*100;
+#else
+			timespec ts;
+			clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+			return static_cast<long long>(ts.tv_sec)*1000000000+ts.tv_nsec;
+#endif
+		}
+	protected:
+		long long start_;
+	};
 }
 
 #endif
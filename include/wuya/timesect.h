@@ -111,8 +111,10 @@ namespace wuya{
 
 	inline int timesection::get_days() const {
 		if (valid()) {
-			datetime t1(time1_.year(), time1_.month(), time1_.day());
-			datetime t2(time2_.year(), time2_.month(), time2_.day());
+			datetime_fields f1 = time1_.fields();
+			datetime_fields f2 = time2_.fields();
+			datetime t1(f1.year, f1.month, f1.day);
+			datetime t2(f2.year, f2.month, f2.day);
 			return(t2-t1).get_days();
 		} else {
 			return -1;
@@ -40,6 +40,8 @@ namespace wuya{
 		int get_minutes() const;
 		//  ȡʱ
 		long get_total_seconds() const;
+		//  ȡʱ΢longתlongΪ32λʱҲ
+		long long get_total_microseconds() const;
 		//  ȡʱһӵ
 		int get_seconds() const;
 	public:
@@ -133,6 +135,10 @@ namespace wuya{
 		return static_cast<long>(span_);
 	}
 
+	inline long long timespan::get_total_microseconds() const {
+		return static_cast<long long>(span_)*1000000;
+	}
+
 	inline int timespan::get_seconds() const {
 		return (int)(get_total_seconds() - get_total_minutes()*60);
 	}
@@ -0,0 +1,16 @@
+#ifndef __WUYA_TLS_H__
+#define __WUYA_TLS_H__
+
+/**
+ * ֲ߳̾洢η
+ * ֻPOD͵ȫֻֻ̬Գʼ
+ *
+ * @author wuya
+ */
+#if defined(_MSC_VER)
+	#define WUYA_TLS __declspec(thread)
+#else
+	#define WUYA_TLS __thread
+#endif
+
+#endif
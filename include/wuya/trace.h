@@ -0,0 +1,369 @@
+#ifndef __WUYA_TRACE_H__
+#define __WUYA_TRACE_H__
+
+#include <cstdio>
+#include <wuya/tls.h>
+#include <wuya/atomic.h>
+#include <wuya/timer.h>
+#include <wuya/spsc_ring.h>
+#if defined(WIN32)||defined(_WIN32)
+	#define _WINSOCKAPI_
+	#include <windows.h>
+#else
+	#include <pthread.h>
+	#include <unistd.h>
+	#if defined(__linux__)
+		#include <sys/syscall.h>
+	#endif
+#endif
+
+/**
+ * ٣¼һδֹʱ䣬ΪChrome trace-event JSON
+ * chrome://tracingPerfettoui.perfetto.dev̲߳鿴ʱ
+ * ֻжWUYA_TRACEʱЧչΪգûκο
+ *
+ * ʹ÷
+ *   wuya::tracer::open("/tmp/app.trace.json");
+ *   // ־̶߳дҲжڵtracer::flush()
+ *   wuya::log_tasks::add(&wuya::tracer::flush);
+ *   ...
+ *   void foo() {
+ *       WUYA_TRACE_SCOPE("foo");
+ *       ...
+ *   }
+ *   ...
+ *   wuya::tracer::close();
+ *
+ * ƺͷַָֻ룬Ҳܺתַ
+ */
+#if defined(WUYA_TRACE)
+	#define WUYA_TRACE_JOIN2(a, b) a##b
+	#define WUYA_TRACE_JOIN(a, b) WUYA_TRACE_JOIN2(a, b)
+	#define WUYA_TRACE_SCOPE_CAT(cat, name) wuya::trace_span WUYA_TRACE_JOIN(wuya_trace_span_, __LINE__)(cat, name)
+	#define WUYA_TRACE_SCOPE(name) WUYA_TRACE_SCOPE_CAT("default", name)
+#else
+	#define WUYA_TRACE_SCOPE_CAT(cat, name)
+	#define WUYA_TRACE_SCOPE(name)
+#endif
+
+namespace wuya{
+	// һɵĸ䣬ʱΪcycle_timerļ
+	struct trace_event {
+		const char* cat;
+		const char* name;
+		long long begin;
+		long long end;
+	};
+
+	// ̵߳ĸٻ壬߳˳дպ̸߳
+	struct trace_buffer {
+		enum { FREE, ACTIVE, EXITED };
+		trace_buffer(unsigned long size, unsigned long tid);
+
+		spsc_ring<trace_event> ring;
+		volatile long state;
+		unsigned long tid;
+		// ʱĸֻ߳޸
+		volatile long dropped;
+	};
+
+	/**
+	 * ٵռдгԱΪ̬
+	 * ¼ֻд뱾̵߳Ļ壨ڴ棩flushʱͳһдļ
+	 *
+	 * @author wuya
+	 */
+	class tracer {
+	public:
+		enum {
+			// ̻̲߳߳¼
+			MAX_BUFFERS = 256
+		};
+		struct config {
+			// ÿ̻߳¼ʱ¼
+			unsigned long buffer_size;
+
+			static config& defaults();
+		};
+		/**
+		 * ʼ٣дļͷ
+		 *
+		 * @param path   ļѴʱ
+		 *
+		 * @return ڸٻļʧʱfalse
+		 */
+		static bool open(const char* path);
+		// ֹͣ٣дʣ¼رļ
+		static void close();
+		static bool enabled();
+		/**
+		 * д̻߳е¼߳е
+		 * һ߳дʱֱӷ
+		 */
+		static void flush();
+		// 򻺳̹߳¼
+		static long dropped();
+		// ¼һ䣬beginendΪcycle_timer::cycles()ֵ
+		static void record(const char* cat, const char* name, long long begin, long long end);
+	private:
+		struct state {
+			trace_buffer* buffers[MAX_BUFFERS];
+			volatile long count;
+			volatile long lock;
+			volatile long enabled;
+			volatile long overflow;
+			std::FILE* file;
+			long long base;
+			double cycles_per_us;
+			bool first;
+			unsigned long pid;
+#if !defined(WIN32)&&!defined(_WIN32)
+			bool key_created;
+			pthread_key_t key;
+#endif
+		};
+		static state& self();
+		static trace_buffer* local_buffer();
+		static trace_buffer* attach_buffer();
+		static unsigned long thread_id();
+		static void thread_exit(void* data);
+		static void write_events();
+		static void write_buffer(trace_buffer* b);
+		static bool try_lock();
+		static void lock();
+		static void unlock();
+	};
+
+	/**
+	 * RAIIĸ䣬ʱǿʼʱ䣬ʱ¼
+	 * δڸʱֻһζȡ־Ŀ
+	 */
+	class trace_span {
+	public:
+		trace_span(const char* cat, const char* name);
+		~trace_span();
+	private:
+		const char* cat_;
+		const char* name_;
+		long long begin_;
+	private:
+		trace_span(const trace_span& );
+		trace_span& operator=(const trace_span& );
+	};
+}
+
+//.............................ʵֲ.............................//
+namespace wuya{
+	inline trace_buffer::trace_buffer(unsigned long size, unsigned long tid)
+		:ring(size),state(ACTIVE),tid(tid),dropped(0) {
+	}
+
+	inline tracer::config& tracer::config::defaults() {
+		static config c = { 16384 };
+		return c;
+	}
+
+	inline tracer::state& tracer::self() {
+		// ֻPODԱ̬ʼڹȺ
+		static state s;
+		return s;
+	}
+
+	inline bool tracer::try_lock() {
+		return atomic_cas(&self().lock, 0, 1);
+	}
+
+	inline void tracer::lock() {
+		while (!try_lock()) {
+			cpu_relax();
+		}
+	}
+
+	inline void tracer::unlock() {
+		atomic_store(&self().lock, 0);
+	}
+
+	inline bool tracer::enabled() {
+		return atomic_load(&self().enabled) != 0;
+	}
+
+	inline unsigned long tracer::thread_id() {
+#if defined(WIN32)||defined(_WIN32)
+		return (unsigned long)GetCurrentThreadId();
+#elif defined(__linux__)
+		return (unsigned long)syscall(SYS_gettid);
+#else
+		return (unsigned long)pthread_self();
+#endif
+	}
+
+	inline void tracer::thread_exit(void* data) {
+		atomic_store(&((trace_buffer*)data)->state, trace_buffer::EXITED);
+	}
+
+	inline trace_buffer* tracer::local_buffer() {
+		static WUYA_TLS trace_buffer* buffer = 0;
+		static WUYA_TLS bool attached = false;
+		if (!attached) {
+			attached = true;
+			buffer = attach_buffer();
+		}
+		return buffer;
+	}
+
+	inline trace_buffer* tracer::attach_buffer() {
+		state& s = self();
+		unsigned long tid = thread_id();
+		trace_buffer* b = 0;
+		lock();
+		for (long i=0; i<s.count; ++i) {
+			if (atomic_cas(&s.buffers[i]->state, trace_buffer::FREE, trace_buffer::ACTIVE)) {
+				b = s.buffers[i];
+				b->tid = tid;
+				b->dropped = 0;
+				break;
+			}
+		}
+		if (b == 0 && s.count < MAX_BUFFERS) {
+			b = new trace_buffer(config::defaults().buffer_size, tid);
+			s.buffers[s.count] = b;
+			atomic_store(&s.count, s.count+1);
+		}
+#if !defined(WIN32)&&!defined(_WIN32)
+		// Windowsû߳˳Ļص岻
+		if (!s.key_created) {
+			s.key_created = pthread_key_create(&s.key, thread_exit) == 0;
+		}
+		if (b != 0 && s.key_created) {
+			pthread_setspecific(s.key, b);
+		}
+#endif
+		unlock();
+		return b;
+	}
+
+	inline void tracer::record(const char* cat, const char* name, long long begin, long long end) {
+		trace_buffer* b = local_buffer();
+		if (b == 0) {
+			atomic_add(&self().overflow, 1);
+			return;
+		}
+		unsigned long pos;
+		trace_event* e = b->ring.claim(pos);
+		if (e == 0) {
+			atomic_store(&b->dropped, b->dropped+1);
+			return;
+		}
+		e->cat = cat;
+		e->name = name;
+		e->begin = begin;
+		e->end = end;
+		b->ring.publish(pos);
+	}
+
+	inline long tracer::dropped() {
+		state& s = self();
+		long n = atomic_load(&s.overflow);
+		long count = atomic_load(&s.count);
+		for (long i=0; i<count; ++i) {
+			n += atomic_load(&s.buffers[i]->dropped);
+		}
+		return n;
+	}
+
+	inline bool tracer::open(const char* path) {
+		state& s = self();
+		lock();
+		if (s.file != 0) {
+			unlock();
+			return false;
+		}
+		s.file = std::fopen(path, "w");
+		if (s.file == 0) {
+			unlock();
+			return false;
+		}
+		std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", s.file);
+		s.first = true;
+#if defined(WIN32)||defined(_WIN32)
+		s.pid = (unsigned long)GetCurrentProcessId();
+#else
+		s.pid = (unsigned long)getpid();
+#endif
+		s.cycles_per_us = cycle_timer::cycles_per_ns()*1000;
+		s.base = cycle_timer::cycles();
+		atomic_store(&s.enabled, 1);
+		unlock();
+		return true;
+	}
+
+	inline void tracer::close() {
+		state& s = self();
+		atomic_store(&s.enabled, 0);
+		lock();
+		if (s.file != 0) {
+			write_events();
+			std::fputs("\n]}\n", s.file);
+			std::fclose(s.file);
+			s.file = 0;
+		}
+		unlock();
+	}
+
+	inline void tracer::flush() {
+		if (!try_lock()) {
+			return;
+		}
+		if (self().file != 0) {
+			write_events();
+			std::fflush(self().file);
+		}
+		unlock();
+	}
+
+	inline void tracer::write_events() {
+		state& s = self();
+		long count = atomic_load(&s.count);
+		for (long i=0; i<count; ++i) {
+			trace_buffer* b = s.buffers[i];
+			// ȶ״̬ȡ¼EXITEDʱ߳˳ǰ¼ֶȡ
+			bool exited = atomic_load(&b->state) == trace_buffer::EXITED;
+			write_buffer(b);
+			// ߳ȡܸãԳȡһΣ˳ŷ¼Ҳԭ߳д
+			if (exited && atomic_cas(&b->state, trace_buffer::EXITED, trace_buffer::FREE)) {
+				write_buffer(b);
+			}
+		}
+	}
+
+	inline void tracer::write_buffer(trace_buffer* b) {
+		state& s = self();
+		unsigned long pos;
+		trace_event* e;
+		while ((e = b->ring.peek(pos)) != 0) {
+			// һθٹرպŽ䲻д
+			if (e->begin >= s.base) {
+				std::fprintf(s.file, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%lu,\"tid\":%lu}",
+					s.first?"":",\n", e->name, e->cat,
+					(double)(e->begin-s.base)/s.cycles_per_us, (double)(e->end-e->begin)/s.cycles_per_us,
+					s.pid, b->tid);
+				s.first = false;
+			}
+			b->ring.release(pos);
+		}
+	}
+
+	inline trace_span::trace_span(const char* cat, const char* name):cat_(cat),name_(name),begin_(0) {
+		if (tracer::enabled()) {
+			begin_ = cycle_timer::cycles();
+		}
+	}
+
+	inline trace_span::~trace_span() {
+		if (begin_ != 0) {
+			tracer::record(cat_, name_, begin_, cycle_timer::cycles());
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,47 @@
+/**
+ * ־wuya/binlog.hתΪı־ĸʽ׼
+ *
+ * 룺
+ *   g++ -O2 -I../include binlog2text.cpp -o binlog2text -lACE
+ * ÷
+ *   binlog2text [-u] -f ļ...
+ *   -u ʱ侫ȷ΢룬ȱʡΪ
+ *
+ * @author wuya
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <wuya/binlog.h>
+#include <wuya/get_opt.h>
+
+int main(int argc, const char** argv) {
+	wuya::get_opt opt(argc, argv);
+	int files = opt.get_option_param_size('f');
+	if (files <= 0) {
+		fprintf(stderr, "usage: binlog2text [-u] -f file...\n");
+		return 2;
+	}
+	if (opt.has_option('u')) {
+		wuya::log_clock::set_precision(6);
+	}
+	int ret = 0;
+	std::string line;
+	for (int i=0; i<files; ++i) {
+		const char* name = opt.get_option_param('f', i);
+		wuya::binlog_decoder decoder;
+		if (!decoder.open(name)) {
+			fprintf(stderr, "%s: not a binary log\n", name);
+			ret = 1;
+			continue;
+		}
+		while (decoder.next(line)) {
+			fwrite(line.data(), 1, line.size(), stdout);
+		}
+		if (decoder.error()) {
+			fprintf(stderr, "%s: corrupted record\n", name);
+			ret = 1;
+		}
+	}
+	return ret;
+}
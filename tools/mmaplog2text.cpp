@@ -0,0 +1,53 @@
+/**
+ * ȡڴӳ价־wuya/mmap_log.hеļ¼д˳׼
+ * ڽָ̱־
+ *
+ * 룺
+ *   g++ -O2 -I../include mmaplog2text.cpp -o mmaplog2text -lACE
+ * ÷
+ *   mmaplog2text [-l ] -f ļ...
+ *   -l ֻڸüļ¼0 ERROR1 WARN2 INFO3 DEBUG
+ *
+ * @author wuya
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <wuya/mmap_log.h>
+#include <wuya/get_opt.h>
+
+int main(int argc, const char** argv) {
+	wuya::get_opt opt(argc, argv);
+	int files = opt.get_option_param_size('f');
+	if (files <= 0) {
+		fprintf(stderr, "usage: mmaplog2text [-l level] -f file...\n");
+		return 2;
+	}
+	int max_level = wuya::LOG_DEBUG;
+	if (opt.has_option('l')) {
+		max_level = atoi(opt.get_option_param('l'));
+	}
+	int ret = 0;
+	std::string msg;
+	wuya::LOGLEVEL level;
+	for (int i=0; i<files; ++i) {
+		const char* name = opt.get_option_param('f', i);
+		wuya::mmap_log_reader reader;
+		if (!reader.open(name)) {
+			fprintf(stderr, "%s: not a mapped log\n", name);
+			ret = 1;
+			continue;
+		}
+		while (reader.next(msg, level)) {
+			if (level > max_level) {
+				continue;
+			}
+			fwrite(msg.data(), 1, msg.size(), stdout);
+			// ضϵļ¼ϻ
+			if (msg.empty() || msg[msg.size()-1] != '\n') {
+				fputc('\n', stdout);
+			}
+		}
+	}
+	return ret;
+}